@@ -3,6 +3,10 @@
 #include <stdint.h>
 #include "fq/fq_mat_types.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 enum { AES_BLOCK_SIZE = 16U };
 
 fq_mat_t aes128_frombytes(const uint8_t *data);
@@ -22,3 +26,7 @@ fq_mat_t aes128_mixcolumns(fq_mat_t blk);
 fq_mat_t aes128_schedule(fq_mat_t key, size_t round);
 
 void aes128_encrypt_block(uint8_t *cip, const uint8_t *key, const uint8_t *msg);
+
+#ifdef __cplusplus
+}
+#endif
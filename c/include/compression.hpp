@@ -0,0 +1,167 @@
+#pragma once
+
+#include "aes.h"
+#include "tc05.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace detail
+{
+    template<typename T, size_t sz>
+    constexpr T load_be(const std::array<uint8_t, sz> &v)
+    {
+        T x = 0;
+
+        for (size_t i = 0; i < sz; ++i)
+            x = static_cast<T>(x << CHAR_BIT | v[i]);
+
+        return x;
+    }
+
+    template<typename T, size_t sz>
+    constexpr void store_be(std::array<uint8_t, sz> &v, T x)
+    {
+        for (size_t i = 0; i < sz; ++i)
+            v[sz - 1 - i] = static_cast<uint8_t>(x >> (CHAR_BIT * i));
+    }
+} // namespace detail
+
+// Byte-oriented view of AES-128
+class Aes128Cipher
+{
+public:
+    static constexpr size_t KEY_SZ = AES_BLOCK_SIZE;
+    static constexpr size_t BLK_SZ = AES_BLOCK_SIZE;
+
+    using Key = std::array<uint8_t, KEY_SZ>;
+    using Blk = std::array<uint8_t, BLK_SZ>;
+
+    Aes128Cipher() = delete;
+
+    static Blk encrypt(const Key &key, const Blk &pln)
+    {
+        Blk cip;
+
+        aes128_encrypt_block(cip.data(), key.data(), pln.data());
+
+        return cip;
+    }
+};
+
+// Byte-oriented view of TC05 (big-endian key and block)
+class Tc05Cipher
+{
+public:
+    static constexpr size_t KEY_SZ = sizeof(uint64_t);
+    static constexpr size_t BLK_SZ = sizeof(uint32_t);
+
+    using Key = std::array<uint8_t, KEY_SZ>;
+    using Blk = std::array<uint8_t, BLK_SZ>;
+
+    Tc05Cipher() = delete;
+
+    static Blk encrypt(const Key &key, const Blk &pln)
+    {
+        Blk cip;
+        uint32_t m = detail::load_be<uint32_t>(pln);
+        uint64_t k = detail::load_be<uint64_t>(key);
+
+        detail::store_be(cip, crypto::tc05::enc(m, k));
+
+        return cip;
+    }
+};
+
+// Common interface of the block-cipher based compression functions. A compression message is
+// laid out as [chaining value | message block], like MerkleDamgard builds it, and the digest is
+// the truncated feed-forward output of the cipher.
+template<typename Derived, typename Cipher, size_t msg_sz, size_t dig_sz>
+class CipherCompression
+{
+    static_assert(msg_sz > dig_sz, "Not a compression function! (msg_sz <= dig_sz)");
+
+public:
+    static constexpr size_t MSG_SZ = msg_sz;
+    static constexpr size_t DIG_SZ = dig_sz;
+
+    using Msg = std::array<uint8_t, MSG_SZ>;
+    using Dig = std::array<uint8_t, DIG_SZ>;
+
+    CipherCompression() = delete;
+
+    static void hash_batch(std::span<const Msg> msgs, std::span<Dig> digs)
+    {
+#pragma omp parallel for
+        for (size_t i = 0; i < msgs.size(); ++i)
+            digs[i] = Derived::hash(msgs[i]);
+    }
+
+protected:
+    static Dig feed_forward(const typename Cipher::Blk &cip, const typename Cipher::Blk &pln)
+    {
+        Dig dig;
+
+        for (size_t i = 0; i < DIG_SZ; ++i)
+            dig[i] = cip[i] ^ pln[i];
+
+        return dig;
+    }
+};
+
+// Davies-Meyer: H' = trunc(E_m(H) ^ H), the message block is the key
+template<typename Cipher, size_t msg_sz, size_t dig_sz>
+class DaviesMeyer
+    : public CipherCompression<DaviesMeyer<Cipher, msg_sz, dig_sz>, Cipher, msg_sz, dig_sz>
+{
+    using Base = CipherCompression<DaviesMeyer, Cipher, msg_sz, dig_sz>;
+
+    static_assert(dig_sz <= Cipher::BLK_SZ, "Digest does not fit in a cipher block!");
+    static_assert(msg_sz - dig_sz <= Cipher::KEY_SZ, "Message block does not fit in a key!");
+
+public:
+    using typename Base::Dig;
+    using typename Base::Msg;
+
+    static Dig hash(const Msg &msg)
+    {
+        typename Cipher::Key key{};
+        typename Cipher::Blk pln{};
+
+        std::copy_n(msg.begin(), dig_sz, pln.begin());
+        std::copy(msg.begin() + dig_sz, msg.end(), key.begin());
+
+        return Base::feed_forward(Cipher::encrypt(key, pln), pln);
+    }
+};
+
+// Matyas-Meyer-Oseas: H' = trunc(E_H(m) ^ m), the chaining value is the key
+template<typename Cipher, size_t msg_sz, size_t dig_sz>
+class MatyasMeyerOseas
+    : public CipherCompression<MatyasMeyerOseas<Cipher, msg_sz, dig_sz>, Cipher, msg_sz, dig_sz>
+{
+    using Base = CipherCompression<MatyasMeyerOseas, Cipher, msg_sz, dig_sz>;
+
+    static_assert(dig_sz <= Cipher::KEY_SZ, "Digest does not fit in a key!");
+    static_assert(dig_sz <= Cipher::BLK_SZ, "Digest does not fit in a cipher block!");
+    static_assert(msg_sz - dig_sz <= Cipher::BLK_SZ, "Message block does not fit in a block!");
+
+public:
+    using typename Base::Dig;
+    using typename Base::Msg;
+
+    static Dig hash(const Msg &msg)
+    {
+        typename Cipher::Key key{};
+        typename Cipher::Blk pln{};
+
+        std::copy_n(msg.begin(), dig_sz, key.begin());
+        std::copy(msg.begin() + dig_sz, msg.end(), pln.begin());
+
+        return Base::feed_forward(Cipher::encrypt(key, pln), pln);
+    }
+};
@@ -58,10 +58,26 @@ fq_t fq_self_mul(fq_t x, fq_t y, zp_poly_t r, uint64_t p);
 
 fq_t fq_mul(fq_t x, fq_t y, zp_poly_t r, uint64_t p);
 
+// Products reduced by a context for r (see zp_poly_rem_ctx_new), for loops of many of them
+fq_t fq_self_mul_ctx(fq_t x, fq_t y, const zp_poly_rem_ctx_t *ctx);
+
+fq_t fq_mul_ctx(fq_t x, fq_t y, const zp_poly_rem_ctx_t *ctx);
+
 fq_t fq_self_pow(fq_t x, uint64_t n, zp_poly_t r, uint64_t p);
 
 fq_t fq_pow(fq_t x, uint64_t n, zp_poly_t r, uint64_t p);
 
+// Table for x^y, costing at most ceil(bits / 4) - 1 products per power with y < 2^bits. Larger y
+// are still right, the digits past the table are raised by a full exponentiation.
+fq_pow_table_t fq_pow_table_new(fq_t x, size_t bits, zp_poly_t r, uint64_t p);
+
+void fq_pow_table_del(fq_pow_table_t t);
+
+fq_t fq_pow_table_pow(fq_pow_table_t t, uint64_t y, zp_poly_t r, uint64_t p);
+
+// x[0]^y[0] * ... * x[n - 1]^y[n - 1], sharing the squarings between all the bases
+fq_t fq_multi_pow(const fq_t *x, const uint64_t *y, size_t n, zp_poly_t r, uint64_t p);
+
 fq_t fq_self_inv(fq_t x, zp_poly_t r, uint64_t p);
 
 fq_t fq_inv(fq_t x, zp_poly_t r, uint64_t p);
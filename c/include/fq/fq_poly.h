@@ -53,6 +53,10 @@ fq_poly_t fq_poly_rem(fq_poly_t x, fq_poly_t y, zp_poly_t r, uint64_t p);
 
 fq_t fq_poly_eval(fq_poly_t x, fq_t a, zp_poly_t r, uint64_t p);
 
+// Monic, zero only if both x and y are
+fq_poly_t fq_poly_gcd(fq_poly_t x, fq_poly_t y, zp_poly_t r, uint64_t p);
+
+// Ben-Or's test, polynomial in deg(x), deg(r) and log(p)
 bool fq_poly_is_irred(fq_poly_t x, zp_poly_t r, uint64_t p);
 
 fq_poly_t fq_poly_find_irred(zp_poly_t r, uint64_t p, size_t k);
@@ -6,3 +6,11 @@ typedef struct
 {
     zp_poly_t v;
 } fq_t;
+
+// Powers of a fixed base x: row i holds x^(d * 2^(w * i)) for d = 1, ..., 2^w - 1
+typedef struct
+{
+    fq_t *c;
+    size_t w; // digit size in bits
+    size_t n; // number of rows
+} fq_pow_table_t;
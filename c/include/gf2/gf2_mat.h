@@ -0,0 +1,53 @@
+#pragma once
+
+#include "gf2_mat_types.h"
+#include "gf2_vec_types.h"
+#include "zp/zp_mat_types.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+gf2_mat_t gf2_mat_new(size_t rows, size_t cols);
+
+gf2_mat_t gf2_mat_new_copy(gf2_mat_t x);
+
+gf2_mat_t gf2_mat_new_view(gf2_mat_t x);
+
+gf2_mat_t gf2_mat_new_identity(size_t n);
+
+void gf2_mat_del(gf2_mat_t x);
+
+void gf2_mat_copy(gf2_mat_t *x, gf2_mat_t y);
+
+void gf2_mat_move(gf2_mat_t *x, gf2_mat_t y);
+
+gf2_vec_t gf2_mat_row_view(gf2_mat_t x, size_t i);
+
+bool gf2_mat_get(gf2_mat_t x, size_t i, size_t j);
+
+void gf2_mat_set(gf2_mat_t x, size_t i, size_t j, bool b);
+
+gf2_mat_t gf2_mat_trans(gf2_mat_t x);
+
+gf2_mat_t gf2_mat_self_add(gf2_mat_t x, gf2_mat_t y);
+
+gf2_mat_t gf2_mat_add(gf2_mat_t x, gf2_mat_t y);
+
+// Method of the Four Russians
+gf2_mat_t gf2_mat_mul(gf2_mat_t x, gf2_mat_t y);
+
+gf2_vec_t gf2_mat_vmul(gf2_mat_t x, gf2_vec_t y);
+
+// Reduced row echelon form, by M4RI elimination. The rank is stored in `rank` if not NULL.
+gf2_mat_t gf2_mat_self_rref(gf2_mat_t x, size_t *rank);
+
+gf2_mat_t gf2_mat_rref(gf2_mat_t x, size_t *rank);
+
+size_t gf2_mat_rank(gf2_mat_t x);
+
+// Coefficients are taken mod 2
+gf2_mat_t gf2_mat_from_zp_mat(zp_mat_t x);
+
+zp_mat_t gf2_mat_to_zp_mat(gf2_mat_t x);
+
+void gf2_mat_print(FILE *stream, gf2_mat_t x);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "gf2_vec_types.h"
+
+// Bit-packed matrix over GF(2), row-major, each row padded to GF2_WORDS(cols) words
+typedef struct
+{
+    uint64_t *c;
+    size_t rows;
+    size_t cols;
+} gf2_mat_t;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "gf2_vec_types.h"
+#include "zp/zp_vec_types.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+gf2_vec_t gf2_vec_new_empty(size_t n);
+
+gf2_vec_t gf2_vec_new(size_t n);
+
+gf2_vec_t gf2_vec_new_copy(gf2_vec_t x);
+
+gf2_vec_t gf2_vec_new_view(gf2_vec_t x);
+
+void gf2_vec_del(gf2_vec_t x);
+
+void gf2_vec_copy(gf2_vec_t *x, gf2_vec_t y);
+
+void gf2_vec_move(gf2_vec_t *x, gf2_vec_t y);
+
+bool gf2_vec_get(gf2_vec_t x, size_t i);
+
+void gf2_vec_set(gf2_vec_t x, size_t i, bool b);
+
+bool gf2_vec_is_zero(gf2_vec_t x);
+
+gf2_vec_t gf2_vec_self_add(gf2_vec_t x, gf2_vec_t y);
+
+gf2_vec_t gf2_vec_add(gf2_vec_t x, gf2_vec_t y);
+
+gf2_vec_t gf2_vec_self_hmul(gf2_vec_t x, gf2_vec_t y);
+
+gf2_vec_t gf2_vec_hmul(gf2_vec_t x, gf2_vec_t y);
+
+// Hamming weight
+size_t gf2_vec_weight(gf2_vec_t x);
+
+bool gf2_vec_dot(gf2_vec_t x, gf2_vec_t y);
+
+// Coefficients are taken mod 2
+gf2_vec_t gf2_vec_from_zp_vec(zp_vec_t x);
+
+zp_vec_t gf2_vec_to_zp_vec(gf2_vec_t x);
+
+void gf2_vec_print(FILE *f, gf2_vec_t x);
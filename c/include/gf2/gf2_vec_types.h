@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GF2_WORD_BITS 64
+
+// Number of words holding n bits
+#define GF2_WORDS(n) (((n) + GF2_WORD_BITS - 1) / GF2_WORD_BITS)
+
+// Bit-packed vector over GF(2): bit i is bit i % 64 of word i / 64, the padding bits of the last
+// word are kept at zero
+typedef struct
+{
+    uint64_t *c;
+    size_t n;
+} gf2_vec_t;
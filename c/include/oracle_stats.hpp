@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+// Query counter and latency histogram of an oracle. Counters are sharded across cache lines and
+// updated with relaxed atomics, so oracles can be queried from any number of threads. Every
+// instance registers itself and, if the ORACLE_STATS environment variable is set, all of them are
+// dumped as JSON at exit to the file it names.
+//
+// Instances are trivially destructible on purpose, so they are still alive when the atexit
+// handler runs, whatever the order of static destruction.
+class OracleStats
+{
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t HIST_BINS = 64; // bin i counts latencies in [2^(i-1), 2^i) ns
+
+private:
+    static constexpr size_t MAX_ORACLES = 64;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> queries;
+        std::atomic<uint64_t> ns;
+        std::array<std::atomic<uint64_t>, HIST_BINS> hist;
+    };
+
+    const char *name;
+    std::array<Shard, SHARDS> shards{};
+
+    static inline std::array<OracleStats *, MAX_ORACLES> registry{};
+    static inline std::atomic<size_t> registry_sz{0};
+
+    static Shard &local_shard(OracleStats &stats)
+    {
+        static thread_local size_t id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+        return stats.shards[id % SHARDS];
+    }
+
+    template<typename F>
+    uint64_t sum(F &&f) const
+    {
+        uint64_t s = 0;
+
+        for (auto &&shard : shards)
+            s += f(shard);
+
+        return s;
+    }
+
+public:
+    // Time a single query, recording it when going out of scope
+    class Probe
+    {
+        OracleStats &stats;
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+
+    public:
+        explicit Probe(OracleStats &stats) : stats{stats} {}
+
+        Probe(const Probe &) = delete;
+
+        ~Probe()
+        {
+            auto dt = std::chrono::steady_clock::now() - start;
+
+            stats.record(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+        }
+    };
+
+    explicit OracleStats(const char *name) : name{name}
+    {
+        size_t i = registry_sz.fetch_add(1);
+
+        if (i == 0)
+            std::atexit(dump_all);
+        if (i < MAX_ORACLES)
+            registry[i] = this;
+    }
+
+    OracleStats(const OracleStats &) = delete;
+
+    void rename(const char *new_name) { name = new_name; }
+
+    // Record `n` queries that took `ns` nanoseconds overall
+    void record(uint64_t ns, uint64_t n = 1)
+    {
+        if (n == 0)
+            return;
+
+        Shard &shard = local_shard(*this);
+        size_t bin = std::min<size_t>(std::bit_width(ns / n), HIST_BINS - 1);
+
+        shard.queries.fetch_add(n, std::memory_order_relaxed);
+        shard.ns.fetch_add(ns, std::memory_order_relaxed);
+        shard.hist[bin].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t queries() const
+    {
+        return sum([](auto &&s) { return s.queries.load(std::memory_order_relaxed); });
+    }
+
+    uint64_t total_ns() const
+    {
+        return sum([](auto &&s) { return s.ns.load(std::memory_order_relaxed); });
+    }
+
+    void reset()
+    {
+        for (auto &&shard : shards)
+        {
+            shard.queries.store(0, std::memory_order_relaxed);
+            shard.ns.store(0, std::memory_order_relaxed);
+            for (auto &&bin : shard.hist)
+                bin.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void dump(FILE *f) const
+    {
+        uint64_t q = queries();
+        uint64_t ns = total_ns();
+
+        std::fprintf(f, "{\"name\": \"%s\", \"queries\": %llu, \"total_ns\": %llu, ", name,
+                     static_cast<unsigned long long>(q), static_cast<unsigned long long>(ns));
+        std::fprintf(f, "\"mean_ns\": %.2f, \"hist_log2_ns\": [", q ? double(ns) / q : 0.0);
+
+        for (size_t i = 0; i < HIST_BINS; ++i)
+            std::fprintf(f, "%s%llu", i ? ", " : "",
+                         static_cast<unsigned long long>(sum([&](auto &&s) {
+                             return s.hist[i].load(std::memory_order_relaxed);
+                         })));
+
+        std::fprintf(f, "]}");
+    }
+
+    static void dump_all()
+    {
+        const char *path = std::getenv("ORACLE_STATS");
+
+        if (!path || !*path)
+            return;
+
+        FILE *f = std::fopen(path, "w");
+        size_t n = std::min(registry_sz.load(), MAX_ORACLES);
+
+        if (!f)
+            return;
+
+        std::fprintf(f, "{\"oracles\": [");
+        for (size_t i = 0, k = 0; i < n; ++i)
+        {
+            // Oracles that were instantiated but never queried are just noise
+            if (registry[i]->queries() == 0)
+                continue;
+
+            std::fprintf(f, "%s\n  ", k++ ? "," : "");
+            registry[i]->dump(f);
+        }
+        std::fprintf(f, "\n]}\n");
+
+        std::fclose(f);
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace crypto::siphash
+{
+    namespace detail
+    {
+        static inline constexpr void round(uint64_t &v0, uint64_t &v1, uint64_t &v2, uint64_t &v3)
+        {
+            v0 += v1;
+            v1 = std::rotl(v1, 13);
+            v1 ^= v0;
+            v0 = std::rotl(v0, 32);
+            v2 += v3;
+            v3 = std::rotl(v3, 16);
+            v3 ^= v2;
+            v0 += v3;
+            v3 = std::rotl(v3, 21);
+            v3 ^= v0;
+            v2 += v1;
+            v1 = std::rotl(v1, 17);
+            v1 ^= v2;
+            v2 = std::rotl(v2, 32);
+        }
+    } // namespace detail
+
+    // SipHash-2-4 of `len` bytes under the 128-bit key (k0, k1)
+    static inline uint64_t siphash24(uint64_t k0, uint64_t k1, const uint8_t *in, size_t len)
+    {
+        uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+        uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+        uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+        uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+        uint64_t m;
+        size_t i = 0;
+
+        for (; i + 8 <= len; i += 8)
+        {
+            std::memcpy(&m, in + i, sizeof(m));
+            v3 ^= m;
+            detail::round(v0, v1, v2, v3);
+            detail::round(v0, v1, v2, v3);
+            v0 ^= m;
+        }
+
+        m = static_cast<uint64_t>(len) << 56;
+        for (size_t j = 0; i + j < len; ++j)
+            m |= static_cast<uint64_t>(in[i + j]) << (8 * j);
+
+        v3 ^= m;
+        detail::round(v0, v1, v2, v3);
+        detail::round(v0, v1, v2, v3);
+        v0 ^= m;
+
+        v2 ^= 0xff;
+        for (int r = 0; r < 4; ++r)
+            detail::round(v0, v1, v2, v3);
+
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+} // namespace crypto::siphash
+
+// Keyed PRF with arbitrary output length (SipHash-2-4 in counter mode), derived from a seed
+class Prf
+{
+    uint64_t k0;
+    uint64_t k1;
+
+    static constexpr uint64_t splitmix64(uint64_t &x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+        return z ^ (z >> 31);
+    }
+
+public:
+    constexpr explicit Prf(uint64_t seed) : k0{splitmix64(seed)}, k1{splitmix64(seed)} {}
+
+    // out = F_k(tweak, in), domain-separated by `tweak`
+    void eval(std::span<uint8_t> out, std::span<const uint8_t> in, uint64_t tweak = 0) const
+    {
+        for (size_t i = 0; i < out.size(); i += sizeof(uint64_t))
+        {
+            uint64_t ctr = tweak << 32 | i / sizeof(uint64_t);
+            uint64_t r = crypto::siphash::siphash24(k0 ^ ctr, k1, in.data(), in.size());
+
+            std::memcpy(out.data() + i, &r, std::min(sizeof(r), out.size() - i));
+        }
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifndef min
@@ -24,3 +25,16 @@ static inline uint64_t pow64(uint64_t x, uint64_t y)
 
     return z;
 }
+
+// Largest window returned by pow_window
+#define POW_WINDOW_MAX 3
+
+// Window size for sliding-window exponentiation by y. A w-bit window costs 2^(w-1) products to
+// tabulate the odd powers, then one product every w + 1 exponent bits or so. w = 4 would only pay
+// off above 80 bits
+static inline size_t pow_window(uint64_t y)
+{
+    size_t bits = y ? 64 - __builtin_clzll(y) : 0;
+
+    return bits <= 12 ? 1 : bits <= 24 ? 2 : POW_WINDOW_MAX;
+}
@@ -2,6 +2,11 @@
 
 #include "zp_types.h"
 #include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 zp_t zp_new(uint64_t x);
 
@@ -23,8 +28,15 @@ zp_t zp_mul(zp_t x, zp_t y, uint64_t p);
 
 zp_t zp_pow(zp_t x, uint64_t y, uint64_t p);
 
+// x[0]^y[0] * ... * x[n - 1]^y[n - 1], sharing the squarings between all the bases
+zp_t zp_multi_pow(const zp_t *x, const uint64_t *y, size_t n, uint64_t p);
+
 zp_t zp_inv(zp_t x, uint64_t p);
 
 zp_t zp_div(zp_t x, zp_t y, uint64_t p);
 
 zp_t zp_rand(uint64_t p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "zp_types.h"
+
+#include <bit>
+#include <cstdint>
+#include <ostream>
+
+// C++ value types for Z/pZ. Zp<p> fixes the modulus at compile time, so every reduction constant
+// is known to the compiler: p = 2^k reduces with a mask, p = 2^k - 1 with shifts and adds, and
+// any other p with multiplications by constants. ZpDyn has the same interface for a modulus
+// chosen at run time, shared by all its instances. Both have the layout of zp_t and convert to
+// and from it, so they mix with the C functions.
+
+namespace detail
+{
+    enum class ZpReduction
+    {
+        MASK,     // p = 2^k
+        MERSENNE, // p = 2^k - 1
+        NARROW,   // p < 2^32: products fit in 64 bits, % by a constant becomes a multiply-shift
+        BARRETT,  // p < 2^62, same as zp_ctx_mul
+        WIDE,     // otherwise, a 128-bit division
+    };
+
+    // Reduction constants of a modulus, all computable at compile time
+    struct ZpModulus
+    {
+        uint64_t p;
+        uint64_t mu; // floor(2^(2k) / p) for BARRETT
+        int k;       // bit length of p
+        ZpReduction red;
+
+        constexpr ZpModulus(uint64_t p) : p{p}, mu{0}, k{static_cast<int>(std::bit_width(p))}, red{}
+        {
+            if (std::has_single_bit(p))
+                red = ZpReduction::MASK;
+            else if (std::has_single_bit(p + 1))
+                red = ZpReduction::MERSENNE;
+            else if (p >> 32 == 0)
+                red = ZpReduction::NARROW;
+            else if (k <= 62)
+            {
+                red = ZpReduction::BARRETT;
+                mu = static_cast<uint64_t>((static_cast<uint128_t>(1) << (2 * k)) / p);
+            }
+            else
+                red = ZpReduction::WIDE;
+        }
+
+        // z mod p, for z < p^2
+        constexpr uint64_t reduce(uint128_t z) const
+        {
+            switch (red)
+            {
+            case ZpReduction::MASK:
+                return static_cast<uint64_t>(z) & (p - 1);
+            case ZpReduction::MERSENNE:
+            {
+                // 2^k = 1 mod p, so the high part folds onto the low part. The first fold leaves
+                // less than 2p (k < 64 here, 2^64 - 1 is WIDE), the second at most p
+                uint64_t r = static_cast<uint64_t>(z & p) + static_cast<uint64_t>(z >> k);
+
+                r = (r & p) + (r >> k);
+
+                return r == p ? 0 : r;
+            }
+            case ZpReduction::NARROW:
+                return static_cast<uint64_t>(z) % p;
+            case ZpReduction::BARRETT:
+            {
+                uint64_t q = static_cast<uint64_t>(
+                    (static_cast<uint128_t>(static_cast<uint64_t>(z >> (k - 1))) * mu) >>
+                    (k + 1));
+                uint64_t r = static_cast<uint64_t>(z) - q * p;
+
+                r -= p & -static_cast<uint64_t>(r >= p);
+                r -= p & -static_cast<uint64_t>(r >= p);
+
+                return r;
+            }
+            default:
+                return static_cast<uint64_t>(z % p);
+            }
+        }
+
+        // Any x < 2^64
+        constexpr uint64_t reduce64(uint64_t x) const
+        {
+            return red == ZpReduction::MASK ? x & (p - 1) : x % p;
+        }
+
+        constexpr uint64_t add(uint64_t x, uint64_t y) const
+        {
+            uint64_t z = x + y;
+
+            if (red == ZpReduction::MASK)
+                return z & (p - 1);
+
+            return (z >= p) | (z < x) ? z - p : z;
+        }
+
+        constexpr uint64_t sub(uint64_t x, uint64_t y) const
+        {
+            if (red == ZpReduction::MASK)
+                return (x - y) & (p - 1);
+
+            return x < y ? x - y + p : x - y;
+        }
+
+        constexpr uint64_t mul(uint64_t x, uint64_t y) const
+        {
+            if (red == ZpReduction::MASK || red == ZpReduction::NARROW)
+                return reduce64(x * y);
+
+            return reduce(static_cast<uint128_t>(x) * y);
+        }
+
+        constexpr uint64_t pow(uint64_t x, uint64_t y) const
+        {
+            uint64_t z = reduce64(1);
+
+            for (; y; y >>= 1)
+            {
+                if (y & 1)
+                    z = mul(z, x);
+
+                x = mul(x, x);
+            }
+
+            return z;
+        }
+
+        // Extended Euclid, keeping a * x = u and b * x = v mod p. 0 if x is not invertible
+        constexpr uint64_t inv(uint64_t x) const
+        {
+            uint64_t u = x;
+            uint64_t v = p;
+            uint64_t a = 1;
+            uint64_t b = 0;
+
+            while (u)
+            {
+                uint64_t q = v / u;
+                uint64_t t = v - q * u;
+                uint64_t c = sub(b, mul(reduce64(q), a));
+
+                v = u;
+                u = t;
+                b = a;
+                a = c;
+            }
+
+            return v == 1 ? b : 0;
+        }
+    };
+
+    // Operators shared by Zp<p> and ZpDyn, which provide modulus() and a raw constructor
+    template<typename Derived>
+    class ZpOps
+    {
+    protected:
+        uint64_t v = 0;
+
+        static constexpr Derived raw(uint64_t x)
+        {
+            Derived z;
+
+            z.v = x;
+
+            return z;
+        }
+
+    public:
+        constexpr uint64_t value() const
+        {
+            return v;
+        }
+
+        constexpr zp_t to_zp() const
+        {
+            return zp_t{v};
+        }
+
+        constexpr explicit operator zp_t() const
+        {
+            return to_zp();
+        }
+
+        constexpr Derived operator+() const
+        {
+            return raw(v);
+        }
+
+        constexpr Derived operator-() const
+        {
+            return raw(Derived::modulus().sub(0, v));
+        }
+
+        constexpr Derived &operator+=(Derived y)
+        {
+            v = Derived::modulus().add(v, y.v);
+
+            return static_cast<Derived &>(*this);
+        }
+
+        constexpr Derived &operator-=(Derived y)
+        {
+            v = Derived::modulus().sub(v, y.v);
+
+            return static_cast<Derived &>(*this);
+        }
+
+        constexpr Derived &operator*=(Derived y)
+        {
+            v = Derived::modulus().mul(v, y.v);
+
+            return static_cast<Derived &>(*this);
+        }
+
+        constexpr Derived &operator/=(Derived y)
+        {
+            return *this *= y.inv();
+        }
+
+        friend constexpr Derived operator+(Derived x, Derived y)
+        {
+            return x += y;
+        }
+
+        friend constexpr Derived operator-(Derived x, Derived y)
+        {
+            return x -= y;
+        }
+
+        friend constexpr Derived operator*(Derived x, Derived y)
+        {
+            return x *= y;
+        }
+
+        friend constexpr Derived operator/(Derived x, Derived y)
+        {
+            return x /= y;
+        }
+
+        friend constexpr bool operator==(Derived x, Derived y)
+        {
+            return x.v == y.v;
+        }
+
+        constexpr Derived pow(uint64_t y) const
+        {
+            return raw(Derived::modulus().pow(v, y));
+        }
+
+        // 0 if not invertible
+        constexpr Derived inv() const
+        {
+            return raw(Derived::modulus().inv(v));
+        }
+
+        friend std::ostream &operator<<(std::ostream &os, Derived x)
+        {
+            return os << x.v;
+        }
+    };
+} // namespace detail
+
+template<uint64_t p>
+class Zp : public detail::ZpOps<Zp<p>>
+{
+    static_assert(p >= 2, "Modulus must be at least 2!");
+
+    friend class detail::ZpOps<Zp>;
+
+    static constexpr detail::ZpModulus MOD{p};
+
+public:
+    constexpr Zp() = default;
+
+    constexpr Zp(uint64_t x)
+    {
+        this->v = MOD.reduce64(x);
+    }
+
+    // x must already be reduced, as the zp_* functions leave it
+    constexpr explicit Zp(zp_t x)
+    {
+        this->v = x.v;
+    }
+
+    static constexpr const detail::ZpModulus &modulus()
+    {
+        return MOD;
+    }
+};
+
+// Z/pZ for a run-time p, set with ZpDyn::set_modulus before any arithmetic. All instances share
+// the modulus, which keeps them as small as zp_t
+class ZpDyn : public detail::ZpOps<ZpDyn>
+{
+    friend class detail::ZpOps<ZpDyn>;
+
+    static inline detail::ZpModulus mod{2};
+
+public:
+    constexpr ZpDyn() = default;
+
+    ZpDyn(uint64_t x)
+    {
+        v = mod.reduce64(x);
+    }
+
+    constexpr explicit ZpDyn(zp_t x)
+    {
+        v = x.v;
+    }
+
+    static void set_modulus(uint64_t p)
+    {
+        mod = detail::ZpModulus{p};
+    }
+
+    static const detail::ZpModulus &modulus()
+    {
+        return mod;
+    }
+};
+
+static_assert(sizeof(Zp<2>) == sizeof(zp_t) && sizeof(ZpDyn) == sizeof(zp_t));
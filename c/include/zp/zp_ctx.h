@@ -0,0 +1,165 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "zp_ctx_types.h"
+#include "zp_types.h"
+
+// Largest modulus size (in bits) for Barrett reduction in zp_ctx_mul
+#define ZP_CTX_BARRETT_BITS 62
+
+// Division-free arithmetic modulo a fixed p. zp_ctx_mul multiplies in normal form with Barrett
+// reduction, falling back to a division for p >= 2^62. The zp_mont_* functions work in
+// Montgomery form (x * 2^64 mod p) and need an odd p: convert with zp_to_mont/zp_from_mont at
+// the boundaries of a computation. Since REDC(x * 2^64 * y) = x * y, a loop multiplying by the
+// same x many times only needs to convert x.
+// The hot functions are inline so that the kernels using them can keep everything in registers.
+
+zp_ctx_t zp_ctx_new(uint64_t p);
+
+static inline zp_t zp_ctx_mul(zp_t x, zp_t y, const zp_ctx_t *ctx)
+{
+    uint128_t z = (uint128_t)x.v * y.v;
+    uint64_t r;
+
+    // Barrett needs two bits of headroom, larger moduli pay for the division
+    if (ctx->k > ZP_CTX_BARRETT_BITS)
+    {
+        _divx64((uint64_t)(z >> 64), (uint64_t)z, ctx->p, &r);
+
+        return (zp_t){r};
+    }
+
+    // q = floor(floor(z / 2^(k-1)) * mu / 2^(k+1)) is at most 2 less than floor(z / p)
+    uint64_t q = (uint64_t)(((uint128_t)(uint64_t)(z >> (ctx->k - 1)) * ctx->mu) >> (ctx->k + 1));
+
+    // Masks rather than branches, which would be mispredicted half the time
+    r = (uint64_t)z - q * ctx->p;
+    r -= ctx->p & -(uint64_t)(r >= ctx->p);
+    r -= ctx->p & -(uint64_t)(r >= ctx->p);
+
+    return (zp_t){r};
+}
+
+// REDC(x * y) = x * y * 2^-64 mod p, for x * y < p * 2^64
+static inline zp_t zp_mont_mul(zp_t x, zp_t y, const zp_ctx_t *ctx)
+{
+    uint128_t t = (uint128_t)x.v * y.v;
+    uint64_t m = (uint64_t)t * ctx->pinv;
+    uint64_t r;
+
+    // m * p = t mod 2^64, so the low halves cancel and (t - m * p) / 2^64 is in (-p, p)
+    uint8_t b = _subb64(0, (uint64_t)(t >> 64), (uint64_t)(((uint128_t)m * ctx->p) >> 64), &r);
+
+    r += ctx->p & -(uint64_t)b;
+
+    return (zp_t){r};
+}
+
+// Addition is the same in normal and Montgomery form, and works for any p
+static inline zp_t zp_ctx_add(zp_t x, zp_t y, const zp_ctx_t *ctx)
+{
+    uint64_t z;
+
+    if (_addc64(0, x.v, y.v, &z) | (z >= ctx->p))
+        z -= ctx->p;
+
+    return (zp_t){z};
+}
+
+static inline zp_t zp_ctx_sub(zp_t x, zp_t y, const zp_ctx_t *ctx)
+{
+    uint64_t z;
+
+    if (_subb64(0, x.v, y.v, &z))
+        z += ctx->p;
+
+    return (zp_t){z};
+}
+
+static inline zp_t zp_mont_one(const zp_ctx_t *ctx)
+{
+    return (zp_t){ctx->r1};
+}
+
+// Any x < 2^64 is accepted, and reduced on the way
+static inline zp_t zp_to_mont(zp_t x, const zp_ctx_t *ctx)
+{
+    return zp_mont_mul(x, (zp_t){ctx->r2}, ctx);
+}
+
+static inline zp_t zp_from_mont(zp_t x, const zp_ctx_t *ctx)
+{
+    return zp_mont_mul(x, (zp_t){1}, ctx);
+}
+
+// x^y, with x and the result in Montgomery form and y a plain integer
+zp_t zp_mont_pow(zp_t x, uint64_t y, const zp_ctx_t *ctx);
+
+// x^-1 in Montgomery form, 0 if x is not invertible
+zp_t zp_mont_inv(zp_t x, const zp_ctx_t *ctx);
+
+// The native form is the fastest one for p: Montgomery for odd p, normal for even p. Code that
+// works for any p can stay in it between zp_to_native and zp_from_native
+static inline zp_t zp_native_mul(zp_t x, zp_t y, const zp_ctx_t *ctx)
+{
+    return ctx->p & 1 ? zp_mont_mul(x, y, ctx) : zp_ctx_mul(x, y, ctx);
+}
+
+static inline zp_t zp_native_one(const zp_ctx_t *ctx)
+{
+    return ctx->p & 1 ? zp_mont_one(ctx) : (zp_t){1 % ctx->p};
+}
+
+// Any x < 2^64 is accepted, and reduced on the way
+static inline zp_t zp_to_native(zp_t x, const zp_ctx_t *ctx)
+{
+    return ctx->p & 1 ? zp_to_mont(x, ctx) : (zp_t){x.v % ctx->p};
+}
+
+static inline zp_t zp_from_native(zp_t x, const zp_ctx_t *ctx)
+{
+    return ctx->p & 1 ? zp_from_mont(x, ctx) : x;
+}
+
+// x^y with x and the result in native form, by sliding windows
+zp_t zp_native_pow(zp_t x, uint64_t y, const zp_ctx_t *ctx);
+
+// Table for x^y, costing at most ceil(bits / 4) - 1 products per power with y < 2^bits. Larger y
+// are still right, the digits past the table are raised by a full exponentiation.
+zp_pow_table_t zp_pow_table_new(zp_t x, uint64_t p, size_t bits);
+
+void zp_pow_table_del(zp_pow_table_t t);
+
+// x^y, in normal form
+zp_t zp_pow_table_pow(const zp_pow_table_t *t, uint64_t y);
+
+// w < p, otherwise the quotient overflows
+static inline zp_prep_t zp_prep_new(zp_t w, uint64_t p)
+{
+    uint64_t r;
+
+    return (zp_prep_t){w, _divx64(w.v, 0, p, &r)};
+}
+
+// x * w mod p for any x < 2^64: the quotient estimate is off by at most one, so a single
+// conditional subtraction is enough
+static inline zp_t zp_prep_mul(zp_t x, zp_prep_t w, uint64_t p)
+{
+    uint64_t q = (uint64_t)(((uint128_t)x.v * w.q) >> 64);
+
+    // x * w - q * p is below 2p, which only fits in 64 bits for p < 2^63
+    if (p >> 63)
+    {
+        uint128_t r = (uint128_t)x.v * w.w.v - (uint128_t)q * p;
+
+        r -= p & -(uint128_t)(r >= p);
+
+        return (zp_t){(uint64_t)r};
+    }
+
+    uint64_t r = x.v * w.w.v - q * p;
+
+    r -= p & -(uint64_t)(r >= p);
+
+    return (zp_t){r};
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "zp_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Precomputed reduction constants for a fixed modulus p
+typedef struct
+{
+    uint64_t p;
+    uint64_t pinv;  // p^-1 mod 2^64, Montgomery only (p odd)
+    uint64_t r1;    // 2^64 mod p, i.e. 1 in Montgomery form
+    uint64_t r2;    // 2^128 mod p, converts to Montgomery form
+    uint64_t mu;    // floor(2^(2k) / p), Barrett only (k <= ZP_CTX_BARRETT_BITS)
+    uint64_t k;     // bit length of p
+} zp_ctx_t;
+
+// Multiplier prepared for repeated products by the same w (Shoup)
+typedef struct
+{
+    zp_t w;
+    uint64_t q; // floor(w * 2^64 / p)
+} zp_prep_t;
+
+// Powers of a fixed base x: row i holds x^(d * 2^(w * i)) for d = 1, ..., 2^w - 1, in the native
+// form of ctx (see zp_ctx.h)
+typedef struct
+{
+    zp_ctx_t ctx;
+    zp_t *c;
+    size_t w; // digit size in bits
+    size_t n; // number of rows
+} zp_pow_table_t;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "zp_vec_types.h"
+#include "zp_ctx_types.h"
 #include "zp_mat_types.h"
 
 #include <stdio.h>
@@ -39,6 +40,10 @@ zp_mat_t zp_mat_self_smul(zp_mat_t x, zp_t a, uint64_t p);
 
 zp_mat_t zp_mat_smul(zp_mat_t x, zp_t a, uint64_t p);
 
+zp_mat_t zp_mat_self_smul_prepared(zp_mat_t x, zp_prep_t a, uint64_t p);
+
+zp_mat_t zp_mat_smul_prepared(zp_mat_t x, zp_prep_t a, uint64_t p);
+
 zp_mat_t zp_mat_self_hmul(zp_mat_t x, zp_mat_t y, uint64_t p);
 
 zp_mat_t zp_mat_hmul(zp_mat_t x, zp_mat_t y, uint64_t p);
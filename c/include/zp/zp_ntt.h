@@ -0,0 +1,30 @@
+#pragma once
+
+#include "zp_ntt_types.h"
+#include "zp_vec_types.h"
+#include <stdbool.h>
+
+// Largest modulus size (in bits) for the transforms, whose butterflies keep values below 4p
+#define ZP_NTT_BITS 62
+
+// Number-theoretic transforms modulo a prime p < 2^ZP_NTT_BITS with 2^lg dividing p - 1. The
+// forward transform leaves its output in bit-reversed order and the inverse one takes it so,
+// which is all a convolution needs. Values are kept in [0, 2p) between the butterflies, and
+// the twiddles are prepared for Shoup products.
+
+// Whether p has a root of unity of order 2^lg (p is assumed prime, as everywhere)
+bool zp_ntt_is_supported(uint64_t p, size_t lg);
+
+zp_ntt_t zp_ntt_new(uint64_t p, size_t lg);
+
+void zp_ntt_del(zp_ntt_t t);
+
+// Table for p covering length 2^lg, built on first use and then kept for the whole process.
+// Safe to call from several threads
+const zp_ntt_t *zp_ntt_get(uint64_t p, size_t lg);
+
+// In place, for x.n a power of 2 up to 2^t->lg and x reduced mod p
+void zp_ntt_forward(zp_vec_t x, const zp_ntt_t *t);
+
+// In place, including the division by x.n
+void zp_ntt_inverse(zp_vec_t x, const zp_ntt_t *t);
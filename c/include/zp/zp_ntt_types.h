@@ -0,0 +1,16 @@
+#pragma once
+
+#include "zp_ctx_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Twiddle factors of the transforms of length up to 2^lg modulo an NTT prime p. The level of
+// half-length m holds w[m + j] = g^(j * 2^lg / 2m) for j < m, with g of order 2^lg, so that a
+// shorter transform uses a prefix of the table. wi holds the inverses
+typedef struct
+{
+    uint64_t p;
+    size_t lg;
+    zp_prep_t *w;
+    zp_prep_t *wi;
+} zp_ntt_t;
@@ -43,6 +43,33 @@ zp_poly_t zp_poly_self_sub(zp_poly_t x, zp_poly_t y, uint64_t p);
 
 zp_poly_t zp_poly_sub(zp_poly_t x, zp_poly_t y, uint64_t p);
 
+// Lengths from which products recurse with Karatsuba and Toom-3 (p coprime to 6 only), and from
+// which zp_poly_self_mul switches to NTTs. The defaults can be overridden at build time or at
+// run time, poly_mul_tune measures them for the host
+#ifndef ZP_POLY_KARATSUBA_THRESHOLD
+    #define ZP_POLY_KARATSUBA_THRESHOLD 64
+#endif
+#ifndef ZP_POLY_TOOM3_THRESHOLD
+    #define ZP_POLY_TOOM3_THRESHOLD 256
+#endif
+#ifndef ZP_POLY_NTT_THRESHOLD
+    #define ZP_POLY_NTT_THRESHOLD 1024
+#endif
+
+void zp_poly_mul_set_thresholds(size_t karatsuba, size_t toom3, size_t ntt);
+
+// Length of the scratch vector needed by zp_poly_self_mul_scratch
+size_t zp_poly_mul_scratch_len(size_t d_x, size_t d_y, uint64_t p);
+
+// Karatsuba/Toom-3 product with the temporaries taken from s, which can be reused across products
+zp_poly_t zp_poly_self_mul_scratch(zp_poly_t x, zp_poly_t y, uint64_t p, zp_vec_t s);
+
+// Product by NTTs, modulo p itself if it is an NTT prime (see zp_ntt.h) and otherwise modulo
+// three fixed primes combined by the CRT, which works for any p
+zp_poly_t zp_poly_self_mul_ntt(zp_poly_t x, zp_poly_t y, uint64_t p);
+
+zp_poly_t zp_poly_mul_ntt(zp_poly_t x, zp_poly_t y, uint64_t p);
+
 zp_poly_t zp_poly_self_mul(zp_poly_t x, zp_poly_t y, uint64_t p);
 
 zp_poly_t zp_poly_mul(zp_poly_t x, zp_poly_t y, uint64_t p);
@@ -51,12 +78,50 @@ zp_poly_t zp_poly_self_rem(zp_poly_t x, zp_poly_t y, uint64_t p);
 
 zp_poly_t zp_poly_rem(zp_poly_t x, zp_poly_t y, uint64_t p);
 
+// Degree of the modulus from which reductions by a context go through its Newton inverse, which
+// turns them into two products. Below it they are long divisions, still without inversions
+#ifndef ZP_POLY_REM_NEWTON_THRESHOLD
+    #define ZP_POLY_REM_NEWTON_THRESHOLD 48
+#endif
+
+// Context for many reductions modulo the same r, which it copies
+zp_poly_rem_ctx_t zp_poly_rem_ctx_new(zp_poly_t r, uint64_t p);
+
+void zp_poly_rem_ctx_del(zp_poly_rem_ctx_t ctx);
+
+zp_poly_t zp_poly_self_rem_ctx(zp_poly_t x, const zp_poly_rem_ctx_t *ctx);
+
+zp_poly_t zp_poly_rem_ctx(zp_poly_t x, const zp_poly_rem_ctx_t *ctx);
+
+// x^n mod r, for the r of ctx
+zp_poly_t zp_poly_self_pow_ctx(zp_poly_t x, uint64_t n, const zp_poly_rem_ctx_t *ctx);
+
+zp_poly_t zp_poly_pow_ctx(zp_poly_t x, uint64_t n, const zp_poly_rem_ctx_t *ctx);
+
+// Monic, zero only if both x and y are
+zp_poly_t zp_poly_gcd(zp_poly_t x, zp_poly_t y, uint64_t p);
+
 bool zp_poly_is_zero(zp_poly_t x);
 
 bool zp_poly_is_one(zp_poly_t x);
 
 zp_t zp_poly_eval(zp_poly_t x, zp_t a, uint64_t p);
 
+// Number of points from which zp_poly_eval_many splits them down the subproduct tree, rather than
+// evaluating each one with Horner
+#ifndef ZP_POLY_EVAL_TREE_THRESHOLD
+    #define ZP_POLY_EVAL_TREE_THRESHOLD 32
+#endif
+
+// x at each point of a, by remainders down the subproduct tree of the points: O(M(d) log d)
+// for d points and degree d, instead of O(d^2)
+zp_vec_t zp_poly_eval_many(zp_poly_t x, zp_vec_t a, uint64_t p);
+
+// The polynomial of degree below a.n taking the values y at the distinct points a, combining
+// Lagrange terms up the subproduct tree
+zp_poly_t zp_poly_interp(zp_vec_t a, zp_vec_t y, uint64_t p);
+
+// Ben-Or's test, polynomial in deg(x) and log(p)
 bool zp_poly_is_irred(zp_poly_t x, uint64_t p);
 
 zp_poly_t zp_poly_find_irred(uint64_t p, size_t k);
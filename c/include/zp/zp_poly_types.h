@@ -1,5 +1,6 @@
 #pragma once
 
+#include "zp_ctx_types.h"
 #include "zp_types.h"
 #include <stdint.h>
 #include <stddef.h>
@@ -9,3 +10,12 @@ typedef struct
     zp_t *c;
     size_t n;
 } zp_poly_t;
+
+// Precomputed data for reductions modulo a fixed r of degree d
+typedef struct
+{
+    zp_poly_t r;
+    zp_poly_t inv;    // rev(r)^-1 mod x^d, with rev(r) = x^d r(1 / x)
+    zp_prep_t lc_inv; // inverse of the leading coefficient of r
+    uint64_t p;
+} zp_poly_rem_ctx_t;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fq/fq_types.h"
+#include "zp_ctx_types.h"
 #include "zp_poly_types.h"
 #include "zp_vec_types.h"
 #include <stdio.h>
@@ -37,6 +38,10 @@ zp_vec_t zp_vec_self_smul(zp_vec_t x, zp_t a, uint64_t p);
 
 zp_vec_t zp_vec_smul(zp_vec_t x, zp_t a, uint64_t p);
 
+zp_vec_t zp_vec_self_smul_prepared(zp_vec_t x, zp_prep_t a, uint64_t p);
+
+zp_vec_t zp_vec_smul_prepared(zp_vec_t x, zp_prep_t a, uint64_t p);
+
 zp_vec_t zp_vec_self_hmul(zp_vec_t x, zp_vec_t y, uint64_t p);
 
 zp_vec_t zp_vec_hmul(zp_vec_t x, zp_vec_t y, uint64_t p);
@@ -8,6 +8,9 @@
 #include "zp/zp_poly.h"
 #include "zp/zp_vec.h"
 
+#include <limits.h>
+#include <threads.h>
+
 enum
 {
     AES_DEBUG_PRINT = 0U, // AES print debug information
@@ -133,6 +136,7 @@ fq_mat_t aes128_shiftrows(fq_mat_t blk)
             t = fq_poly_self_mul(t, AES_SHIFTROWS_POLY, AES_R, AES_P);
             t = fq_poly_self_rem(t, AES_ROT_R, AES_R, AES_P);
         }
+        fq_poly_resize(&t, AES_COLS - 1);
 
         for (size_t j = 0; j < AES_COLS; ++j)
             fq_copy(&blk.c[i * AES_COLS + j], t.c[j]);
@@ -153,6 +157,7 @@ fq_mat_t aes128_mixcolumns(fq_mat_t blk)
 
         t = fq_poly_self_mul(t, AES_MIXCOLUMNS_POLY, AES_R, AES_P);
         t = fq_poly_self_rem(t, AES_ROT_R, AES_R, AES_P);
+        fq_poly_resize(&t, AES_ROWS - 1);
 
         for (size_t j = 0; j < AES_ROWS; ++j)
             fq_copy(&blk.c[i * AES_ROWS + j], t.c[j]);
@@ -163,6 +168,19 @@ fq_mat_t aes128_mixcolumns(fq_mat_t blk)
     return fq_mat_self_trans(blk);
 }
 
+// Powers of alpha for the round constants, built on first use: the key schedule then needs a
+// single product per round constant, or none at all for r < 16
+static fq_pow_table_t AES_RC_TABLE;
+static once_flag AES_RC_ONCE = ONCE_FLAG_INIT;
+
+static void aes128_rc_init(void)
+{
+    fq_t alpha = fq_from_int(AES_ALPHA, AES_P);
+
+    AES_RC_TABLE = fq_pow_table_new(alpha, sizeof(size_t) * CHAR_BIT, AES_R, AES_P);
+    fq_del(alpha);
+}
+
 fq_mat_t aes128_schedule(fq_mat_t key, size_t r)
 {
     key = fq_mat_self_trans(key);
@@ -180,7 +198,8 @@ fq_mat_t aes128_schedule(fq_mat_t key, size_t r)
         t.c[i] = aes128_sbox(t.c[i]);
 
     // round constant: alpha^r
-    fq_t rc = fq_self_pow(fq_from_int(AES_ALPHA, AES_P), r, AES_R, AES_P);
+    call_once(&AES_RC_ONCE, aes128_rc_init);
+    fq_t rc = fq_pow_table_pow(AES_RC_TABLE, r, AES_R, AES_P);
 
     t.c[0] = fq_self_add(t.c[0], rc, AES_P);
     fq_vec_self_add(fq_mat_row_view(key, 0), fq_vec_from_fq_poly_view(t), AES_P);
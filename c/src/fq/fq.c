@@ -5,6 +5,8 @@
 #include "zp/zp_poly.h"
 #include "zp/zp_vec.h"
 
+#include <stdlib.h>
+
 size_t fq_digits(fq_t x)
 {
     return x.v.n;
@@ -148,23 +150,76 @@ fq_t fq_mul(fq_t x, fq_t y, zp_poly_t r, uint64_t p)
     return fq_self_mul(fq_new_copy(x), y, r, p);
 }
 
+fq_t fq_self_mul_ctx(fq_t x, fq_t y, const zp_poly_rem_ctx_t *ctx)
+{
+    zp_poly_move(&x.v, zp_poly_mul(x.v, y.v, ctx->p));
+    x.v = zp_poly_self_rem_ctx(x.v, ctx);
+
+    return x;
+}
+
+fq_t fq_mul_ctx(fq_t x, fq_t y, const zp_poly_rem_ctx_t *ctx)
+{
+    return fq_self_mul_ctx(fq_new_copy(x), y, ctx);
+}
+
 fq_t fq_self_pow(fq_t x, uint64_t n, zp_poly_t r, uint64_t p)
 {
+    fq_t t[1 << (POW_WINDOW_MAX - 1)];
+    size_t w = pow_window(n);
+    size_t i = n ? 64 - __builtin_clzll(n) : 0;
     fq_t z = fq_one();
+    bool first = true;
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
 
-    while (n)
+    // Odd powers x, x^3, ..., x^(2^w - 1), the table takes ownership of x
+    t[0] = x;
+    if (w > 1)
     {
-        if (n & 1)
-            z = fq_self_mul(z, x, r, p);
+        fq_t x2 = fq_mul_ctx(x, x, &ctx);
 
-        x = fq_self_mul(x, x, r, p);
+        for (size_t k = 1; k < (size_t)1 << (w - 1); ++k)
+            t[k] = fq_mul_ctx(t[k - 1], x2, &ctx);
 
-        n >>= 1;
+        fq_del(x2);
     }
 
-    fq_move(&x, z);
+    // Bits [j, i) form a window when both ends are set: it costs i - j squarings and a product
+    while (i)
+    {
+        if (!(n >> (i - 1) & 1))
+        {
+            z = fq_self_mul_ctx(z, z, &ctx);
+            --i;
+            continue;
+        }
+
+        size_t j = i > w ? i - w : 0;
+
+        while (!(n >> j & 1))
+            ++j;
+
+        fq_t d = t[(n >> j & ((1ULL << (i - j)) - 1)) >> 1];
+
+        if (first)
+            fq_copy(&z, d);
+        else
+        {
+            for (size_t k = j; k < i; ++k)
+                z = fq_self_mul_ctx(z, z, &ctx);
+            z = fq_self_mul_ctx(z, d, &ctx);
+        }
+
+        first = false;
+        i = j;
+    }
 
-    return x;
+    for (size_t k = 0; k < (size_t)1 << (w - 1); ++k)
+        fq_del(t[k]);
+
+    zp_poly_rem_ctx_del(ctx);
+
+    return z;
 }
 
 fq_t fq_pow(fq_t x, uint64_t n, zp_poly_t r, uint64_t p)
@@ -172,6 +227,132 @@ fq_t fq_pow(fq_t x, uint64_t n, zp_poly_t r, uint64_t p)
     return fq_self_pow(fq_new_copy(x), n, r, p);
 }
 
+fq_pow_table_t fq_pow_table_new(fq_t x, size_t bits, zp_poly_t r, uint64_t p)
+{
+    fq_pow_table_t t = {.w = 4};
+    size_t d = ((size_t)1 << t.w) - 1;
+
+    t.n = bits ? (bits + t.w - 1) / t.w : 1;
+    t.c = malloc(t.n * d * sizeof *t.c);
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
+    // Row i + 1 starts from x^(2^(w * (i + 1))) = x^(d * 2^(w * i)) * x^(2^(w * i))
+    for (size_t i = 0; i < t.n; ++i)
+    {
+        fq_t *row = t.c + i * d;
+
+        row[0] = i ? fq_mul_ctx(row[-1], row[-d], &ctx) : fq_new_copy(x);
+        for (size_t k = 1; k < d; ++k)
+            row[k] = fq_mul_ctx(row[k - 1], row[0], &ctx);
+    }
+
+    zp_poly_rem_ctx_del(ctx);
+
+    return t;
+}
+
+void fq_pow_table_del(fq_pow_table_t t)
+{
+    for (size_t i = 0; i < t.n * (((size_t)1 << t.w) - 1); ++i)
+        fq_del(t.c[i]);
+
+    free(t.c);
+}
+
+fq_t fq_pow_table_pow(fq_pow_table_t t, uint64_t y, zp_poly_t r, uint64_t p)
+{
+    size_t d = ((size_t)1 << t.w) - 1;
+    fq_t z = fq_one();
+    bool first = true;
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
+    // No squarings at all: one product per non-zero digit of y
+    for (size_t i = 0; i < t.n && y; ++i, y >>= t.w)
+    {
+        if (!(y & d))
+            continue;
+
+        if (first)
+            fq_copy(&z, t.c[i * d + (y & d) - 1]);
+        else
+            z = fq_self_mul_ctx(z, t.c[i * d + (y & d) - 1], &ctx);
+
+        first = false;
+    }
+
+    // Digits past the table: finish with (x^(2^(w * n)))^y
+    if (y)
+    {
+        const fq_t *last = t.c + (t.n - 1) * d;
+        fq_t h = fq_self_pow(fq_mul_ctx(last[d - 1], last[0], &ctx), y, r, p);
+
+        if (first)
+            fq_move(&z, h);
+        else
+        {
+            z = fq_self_mul_ctx(z, h, &ctx);
+            fq_del(h);
+        }
+    }
+
+    zp_poly_rem_ctx_del(ctx);
+
+    return z;
+}
+
+fq_t fq_multi_pow(const fq_t *x, const uint64_t *y, size_t n, zp_poly_t r, uint64_t p)
+{
+    uint64_t m = 0;
+
+    for (size_t k = 0; k < n; ++k)
+        m |= y[k];
+
+    // Straus: fixed w-bit windows, the table of base k holds x[k]^1, ..., x[k]^(2^w - 1)
+    size_t w = pow_window(m);
+    size_t d = ((size_t)1 << w) - 1;
+    size_t bits = m ? 64 - __builtin_clzll(m) : 0;
+    fq_t *t = malloc(n * d * sizeof *t);
+    fq_t z = fq_one();
+    bool first = true; // squarings are skipped while z is still 1
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        t[k * d] = fq_new_copy(x[k]);
+        for (size_t j = 1; j < d; ++j)
+            t[k * d + j] = fq_mul_ctx(t[k * d + j - 1], t[k * d], &ctx);
+    }
+
+    for (size_t i = (bits + w - 1) / w; i--;)
+    {
+        for (size_t j = 0; j < w && !first; ++j)
+            z = fq_self_mul_ctx(z, z, &ctx);
+
+        for (size_t k = 0; k < n; ++k)
+        {
+            uint64_t e = y[k] >> (i * w) & d;
+
+            if (!e)
+                continue;
+
+            if (first)
+                fq_copy(&z, t[k * d + e - 1]);
+            else
+                z = fq_self_mul_ctx(z, t[k * d + e - 1], &ctx);
+
+            first = false;
+        }
+    }
+
+    for (size_t k = 0; k < n * d; ++k)
+        fq_del(t[k]);
+    free(t);
+
+    zp_poly_rem_ctx_del(ctx);
+
+    return z;
+}
+
 fq_t fq_self_inv(fq_t x, zp_poly_t r, uint64_t p)
 {
     return fq_self_pow(x, pow64(p, zp_poly_deg(r)) - 2, r, p);
@@ -199,7 +380,8 @@ fq_t fq_div(fq_t x, fq_t y, zp_poly_t r, uint64_t p)
 
 fq_t fq_rand(zp_poly_t r, uint64_t p)
 {
-    return fq_from_zp_poly_view(zp_poly_from_int(prand64(0, zp_poly_to_int(r, p) - 1), p));
+    // Elements are the p^deg(r) polynomials of degree below deg(r)
+    return fq_from_zp_poly_view(zp_poly_from_int(prand64(0, pow64(p, zp_poly_deg(r)) - 1), p));
 }
 
 uint64_t fq_to_int(fq_t x, uint64_t p)
@@ -2,6 +2,7 @@
 #include "fq/fq.h"
 #include "fq/fq_vec.h"
 #include "utils.h"
+#include "zp/zp_poly.h"
 
 #include <ctype.h>
 #include <inttypes.h>
@@ -195,12 +196,14 @@ fq_poly_t fq_poly_self_rem(fq_poly_t x, fq_poly_t y, zp_poly_t r, uint64_t p)
 {
     size_t d_x = fq_poly_deg(x);
     size_t d_y = fq_poly_deg(y);
+    fq_t lc_inv = fq_inv(y.c[d_y], r, p);
     fq_t c = fq_zero();
     fq_t t = fq_zero();
 
-    for (size_t i = d_x; i >= d_y; --i)
+    // One inversion for all the steps
+    for (size_t i = d_x + 1; i-- > d_y;)
     {
-        fq_move(&c, fq_div(x.c[i], y.c[d_y], r, p));
+        fq_move(&c, fq_mul(x.c[i], lc_inv, r, p));
 
         for (size_t j = 0; j <= d_y; ++j)
         {
@@ -209,6 +212,7 @@ fq_poly_t fq_poly_self_rem(fq_poly_t x, fq_poly_t y, zp_poly_t r, uint64_t p)
         }
     }
 
+    fq_del(lc_inv);
     fq_del(c);
     fq_del(t);
 
@@ -231,23 +235,96 @@ fq_t fq_poly_eval(fq_poly_t x, fq_t a, zp_poly_t r, uint64_t p)
     return y;
 }
 
+static bool fq_poly_is_zero(fq_poly_t x)
+{
+    return fq_poly_deg(x) == 0 && fq_is_zero(x.c[0]);
+}
+
+fq_poly_t fq_poly_gcd(fq_poly_t x, fq_poly_t y, zp_poly_t r, uint64_t p)
+{
+    fq_poly_t a = fq_poly_new_copy(x);
+    fq_poly_t b = fq_poly_new_copy(y);
+
+    while (!fq_poly_is_zero(b))
+    {
+        fq_poly_t t = fq_poly_self_rem(a, b, r, p);
+
+        a = b;
+        b = t;
+    }
+
+    fq_poly_del(b);
+
+    size_t d = fq_poly_deg(a);
+
+    fq_poly_resize(&a, d);
+    if (!fq_is_zero(a.c[d]))
+    {
+        fq_t c = fq_inv(a.c[d], r, p);
+
+        for (size_t i = 0; i <= d; ++i)
+            a.c[i] = fq_self_mul(a.c[i], c, r, p);
+
+        fq_del(c);
+    }
+
+    return a;
+}
+
+// x^n mod y
+static fq_poly_t fq_poly_self_pow_rem(fq_poly_t x, uint64_t n, fq_poly_t y, zp_poly_t r,
+                                      uint64_t p)
+{
+    fq_poly_t z = fq_poly_one();
+
+    x = fq_poly_self_rem(x, y, r, p);
+
+    for (size_t i = n ? 64 - __builtin_clzll(n) : 0; i--;)
+    {
+        z = fq_poly_self_rem(fq_poly_self_mul(z, z, r, p), y, r, p);
+        if (n >> i & 1)
+            z = fq_poly_self_rem(fq_poly_self_mul(z, x, r, p), y, r, p);
+    }
+
+    fq_poly_move(&x, z);
+
+    return x;
+}
+
 bool fq_poly_is_irred(fq_poly_t x, zp_poly_t r, uint64_t p)
 {
-    uint64_t q = pow64(p, fq_poly_deg(x));
-    fq_t a = fq_zero();
+    size_t d = fq_poly_deg(x);
+    size_t k = zp_poly_deg(r);
 
-    for (uint64_t i = 0; i < q; ++i)
+    if (d == 0)
+        return false;
+
+    // Ben-Or, as zp_poly_is_irred with q = p^k: t^(q^i) is raised to p k times per step, so that
+    // q itself may exceed 64 bits
+    fq_poly_t t = fq_poly_new(1);
+    fq_poly_t u = fq_poly_new(1);
+    bool irred = true;
+
+    fq_move(&t.c[1], fq_one());
+    fq_move(&u.c[1], fq_one());
+
+    for (size_t i = 1; i <= d / 2 && irred; ++i)
     {
-        fq_move(&a, fq_from_int(i, p));
-        fq_move(&a, fq_poly_eval(x, a, r, p));
+        for (size_t j = 0; j < k; ++j)
+            u = fq_poly_self_pow_rem(u, p, x, r, p);
+
+        fq_poly_t v = fq_poly_sub(u, t, p);
+        fq_poly_t g = fq_poly_gcd(x, v, r, p);
 
-        if (fq_is_zero(a))
-            return false;
+        irred = fq_poly_deg(g) == 0;
+        fq_poly_del(g);
+        fq_poly_del(v);
     }
 
-    fq_del(a);
+    fq_poly_del(u);
+    fq_poly_del(t);
 
-    return true;
+    return irred;
 }
 
 fq_poly_t fq_poly_find_irred(zp_poly_t r, uint64_t p, size_t k)
@@ -256,7 +333,7 @@ fq_poly_t fq_poly_find_irred(zp_poly_t r, uint64_t p, size_t k)
     fq_poly_t x = fq_poly_new(k);
 
     fq_move(&x.c[0], fq_one());  // constant term must be non-zero
-    fq_move(&x.c[k], fq_zero()); // enforce degree k
+    fq_move(&x.c[k], fq_one());  // enforce degree k
 
     do
         for (size_t i = 1; i < k; ++i)
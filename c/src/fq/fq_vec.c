@@ -1,6 +1,7 @@
 #include "fq/fq_vec.h"
 #include "fq/fq.h"
 #include "fq/fq_poly.h"
+#include "zp/zp_poly.h"
 
 #include <ctype.h>
 #include <stdlib.h>
@@ -98,8 +99,12 @@ fq_vec_t fq_vec_sub(fq_vec_t x, fq_vec_t y, uint64_t p)
 
 fq_vec_t fq_vec_self_smul(fq_vec_t x, fq_t a, zp_poly_t r, uint64_t p)
 {
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = fq_self_mul(x.c[i], a, r, p);
+        x.c[i] = fq_self_mul_ctx(x.c[i], a, &ctx);
+
+    zp_poly_rem_ctx_del(ctx);
 
     return x;
 }
@@ -111,8 +116,12 @@ fq_vec_t fq_vec_smul(fq_vec_t x, fq_t a, zp_poly_t r, uint64_t p)
 
 fq_vec_t fq_vec_self_hmul(fq_vec_t x, fq_vec_t y, zp_poly_t r, uint64_t p)
 {
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = fq_self_mul(x.c[i], y.c[i], r, p);
+        x.c[i] = fq_self_mul_ctx(x.c[i], y.c[i], &ctx);
+
+    zp_poly_rem_ctx_del(ctx);
 
     return x;
 }
@@ -176,9 +185,12 @@ fq_t fq_vec_sum(fq_vec_t x, uint64_t p)
 fq_t fq_vec_prod(fq_vec_t x, zp_poly_t r, uint64_t p)
 {
     fq_t z = fq_one();
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
 
     for (size_t i = 0; i < x.n; ++i)
-        z = fq_self_mul(z, x.c[i], r, p);
+        z = fq_self_mul_ctx(z, x.c[i], &ctx);
+
+    zp_poly_rem_ctx_del(ctx);
 
     return z;
 }
@@ -0,0 +1,306 @@
+#include "gf2/gf2_mat.h"
+#include "gf2/gf2_vec.h"
+#include "utils.h"
+#include "zp/zp_mat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Rows combined per table by the Four Russians methods: 2^8 table rows fit in the L1/L2 caches for
+// matrices a few thousand columns wide
+#define GF2_M4R_BITS 8
+
+static uint64_t *gf2_mat_row(gf2_mat_t x, size_t i)
+{
+    return x.c + i * GF2_WORDS(x.cols);
+}
+
+static bool gf2_bit(const uint64_t *row, size_t j)
+{
+    return row[j / GF2_WORD_BITS] >> (j % GF2_WORD_BITS) & 1;
+}
+
+static void gf2_xor(uint64_t *x, const uint64_t *y, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        x[i] ^= y[i];
+}
+
+// t[s] = sum of the rows rows[q] for the bits q of s, on n words
+static void gf2_m4r_table(uint64_t *t, uint64_t *const *rows, size_t b, size_t n)
+{
+    memset(t, 0, n * sizeof *t);
+
+    for (size_t s = 1; s < (size_t)1 << b; ++s)
+    {
+        memcpy(t + s * n, t + (s & (s - 1)) * n, n * sizeof *t);
+        gf2_xor(t + s * n, rows[__builtin_ctzll(s)], n);
+    }
+}
+
+gf2_mat_t gf2_mat_new(size_t rows, size_t cols)
+{
+    return (gf2_mat_t){
+        .c = calloc(rows * GF2_WORDS(cols), sizeof(uint64_t)), .rows = rows, .cols = cols};
+}
+
+gf2_mat_t gf2_mat_new_copy(gf2_mat_t x)
+{
+    gf2_mat_t y = gf2_mat_new(x.rows, x.cols);
+
+    memcpy(y.c, x.c, x.rows * GF2_WORDS(x.cols) * sizeof *y.c);
+
+    return y;
+}
+
+gf2_mat_t gf2_mat_new_view(gf2_mat_t x)
+{
+    return x;
+}
+
+gf2_mat_t gf2_mat_new_identity(size_t n)
+{
+    gf2_mat_t x = gf2_mat_new(n, n);
+
+    for (size_t i = 0; i < n; ++i)
+        gf2_mat_set(x, i, i, true);
+
+    return x;
+}
+
+void gf2_mat_del(gf2_mat_t x)
+{
+    free(x.c);
+}
+
+void gf2_mat_copy(gf2_mat_t *x, gf2_mat_t y)
+{
+    gf2_mat_del(*x);
+
+    *x = gf2_mat_new_copy(y);
+}
+
+void gf2_mat_move(gf2_mat_t *x, gf2_mat_t y)
+{
+    gf2_mat_del(*x);
+
+    *x = y;
+}
+
+gf2_vec_t gf2_mat_row_view(gf2_mat_t x, size_t i)
+{
+    gf2_vec_t v = {.c = gf2_mat_row(x, i), .n = x.cols};
+
+    return v;
+}
+
+bool gf2_mat_get(gf2_mat_t x, size_t i, size_t j)
+{
+    return gf2_bit(gf2_mat_row(x, i), j);
+}
+
+void gf2_mat_set(gf2_mat_t x, size_t i, size_t j, bool b)
+{
+    gf2_vec_set(gf2_mat_row_view(x, i), j, b);
+}
+
+gf2_mat_t gf2_mat_trans(gf2_mat_t x)
+{
+    gf2_mat_t y = gf2_mat_new(x.cols, x.rows);
+
+    for (size_t i = 0; i < x.rows; ++i)
+    {
+        const uint64_t *row = gf2_mat_row(x, i);
+
+        for (size_t k = 0; k < GF2_WORDS(x.cols); ++k)
+            for (uint64_t w = row[k]; w; w &= w - 1)
+                gf2_mat_set(y, k * GF2_WORD_BITS + __builtin_ctzll(w), i, true);
+    }
+
+    return y;
+}
+
+gf2_mat_t gf2_mat_self_add(gf2_mat_t x, gf2_mat_t y)
+{
+    gf2_xor(x.c, y.c, x.rows * GF2_WORDS(x.cols));
+
+    return x;
+}
+
+gf2_mat_t gf2_mat_add(gf2_mat_t x, gf2_mat_t y)
+{
+    return gf2_mat_self_add(gf2_mat_new_copy(x), y);
+}
+
+gf2_mat_t gf2_mat_mul(gf2_mat_t x, gf2_mat_t y)
+{
+    size_t n = GF2_WORDS(y.cols);
+    gf2_mat_t z = gf2_mat_new(x.rows, y.cols);
+    uint64_t *t = malloc(((size_t)1 << GF2_M4R_BITS) * n * sizeof *t);
+    uint64_t *rows[GF2_M4R_BITS];
+
+    // The 2^8 sums of 8 consecutive rows of y are tabulated, then every row of x adds the one
+    // selected by its 8 bits in those columns: one table lookup replaces 8 row additions
+    for (size_t k = 0; k < x.cols; k += GF2_M4R_BITS)
+    {
+        size_t b = min(GF2_M4R_BITS, x.cols - k);
+
+        for (size_t q = 0; q < b; ++q)
+            rows[q] = gf2_mat_row(y, k + q);
+        gf2_m4r_table(t, rows, b, n);
+
+        // The groups never straddle a word, as 8 divides 64
+        for (size_t i = 0; i < x.rows; ++i)
+        {
+            size_t s = gf2_mat_row(x, i)[k / GF2_WORD_BITS] >> (k % GF2_WORD_BITS) & ((1 << b) - 1);
+
+            if (s)
+                gf2_xor(gf2_mat_row(z, i), t + s * n, n);
+        }
+    }
+
+    free(t);
+
+    return z;
+}
+
+gf2_vec_t gf2_mat_vmul(gf2_mat_t x, gf2_vec_t y)
+{
+    gf2_vec_t z = gf2_vec_new(x.rows);
+
+    for (size_t i = 0; i < x.rows; ++i)
+        gf2_vec_set(z, i, gf2_vec_dot(gf2_mat_row_view(x, i), y));
+
+    return z;
+}
+
+gf2_mat_t gf2_mat_self_rref(gf2_mat_t x, size_t *rank)
+{
+    size_t n = GF2_WORDS(x.cols);
+    uint64_t *t = malloc(((size_t)1 << GF2_M4R_BITS) * n * sizeof *t);
+    uint64_t *rows[GF2_M4R_BITS];
+    size_t piv[GF2_M4R_BITS];
+    size_t r = 0;
+
+    // M4RI: pivots are searched 8 columns at a time, then a table of the combinations of those
+    // pivot rows clears the 8 columns of every other row with a single addition
+    for (size_t c = 0; c < x.cols && r < x.rows; c += GF2_M4R_BITS)
+    {
+        size_t end = min(c + GF2_M4R_BITS, x.cols);
+        size_t w = c / GF2_WORD_BITS; // rows from r on are zero before column c
+        size_t b = 0;
+
+        // Plain Gauss-Jordan within the strip, keeping its pivot rows reduced against each other
+        for (size_t j = c; j < end && r + b < x.rows; ++j)
+        {
+            size_t i = r + b;
+
+            for (; i < x.rows; ++i)
+            {
+                uint64_t *row = gf2_mat_row(x, i);
+
+                for (size_t q = 0; q < b; ++q)
+                    if (gf2_bit(row, piv[q]))
+                        gf2_xor(row + w, rows[q] + w, n - w);
+
+                if (gf2_bit(row, j))
+                    break;
+            }
+
+            if (i == x.rows)
+                continue;
+
+            rows[b] = gf2_mat_row(x, r + b);
+            for (size_t k = w; k < n; ++k)
+            {
+                uint64_t tmp = rows[b][k];
+
+                rows[b][k] = gf2_mat_row(x, i)[k];
+                gf2_mat_row(x, i)[k] = tmp;
+            }
+
+            for (size_t q = 0; q < b; ++q)
+                if (gf2_bit(rows[q], j))
+                    gf2_xor(rows[q] + w, rows[b] + w, n - w);
+
+            piv[b++] = j;
+        }
+
+        if (b == 0)
+            continue;
+
+        // Pivot row q is the only one with a 1 in column piv[q], so t[s] has exactly the bits of s
+        // in the pivot columns
+        gf2_m4r_table(t, rows, b, n);
+
+        for (size_t i = 0; i < x.rows; ++i)
+        {
+            uint64_t *row = gf2_mat_row(x, i);
+            size_t s = 0;
+
+            if (i >= r && i < r + b)
+                continue;
+
+            for (size_t q = 0; q < b; ++q)
+                s |= (size_t)gf2_bit(row, piv[q]) << q;
+
+            if (s)
+                gf2_xor(row + w, t + s * n + w, n - w);
+        }
+
+        r += b;
+    }
+
+    free(t);
+
+    if (rank)
+        *rank = r;
+
+    return x;
+}
+
+gf2_mat_t gf2_mat_rref(gf2_mat_t x, size_t *rank)
+{
+    return gf2_mat_self_rref(gf2_mat_new_copy(x), rank);
+}
+
+size_t gf2_mat_rank(gf2_mat_t x)
+{
+    size_t r;
+
+    gf2_mat_del(gf2_mat_rref(x, &r));
+
+    return r;
+}
+
+gf2_mat_t gf2_mat_from_zp_mat(zp_mat_t x)
+{
+    gf2_mat_t y = gf2_mat_new(x.rows, x.cols);
+
+    for (size_t i = 0; i < x.rows; ++i)
+        for (size_t j = 0; j < x.cols; ++j)
+            gf2_mat_row(y, i)[j / GF2_WORD_BITS] |= (x.c[i * x.cols + j].v & 1)
+                                                    << (j % GF2_WORD_BITS);
+
+    return y;
+}
+
+zp_mat_t gf2_mat_to_zp_mat(gf2_mat_t x)
+{
+    zp_mat_t y = zp_mat_new(x.rows, x.cols);
+
+    for (size_t i = 0; i < x.rows; ++i)
+        for (size_t j = 0; j < x.cols; ++j)
+            y.c[i * x.cols + j].v = gf2_mat_get(x, i, j);
+
+    return y;
+}
+
+void gf2_mat_print(FILE *stream, gf2_mat_t x)
+{
+    for (size_t i = 0; i < x.rows; ++i)
+    {
+        gf2_vec_print(stream, gf2_mat_row_view(x, i));
+        fputc('\n', stream);
+    }
+}
@@ -0,0 +1,149 @@
+#include "gf2/gf2_vec.h"
+#include "zp/zp_vec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+gf2_vec_t gf2_vec_new_empty(size_t n)
+{
+    return (gf2_vec_t){.c = malloc(GF2_WORDS(n) * sizeof(uint64_t)), .n = n};
+}
+
+gf2_vec_t gf2_vec_new(size_t n)
+{
+    return (gf2_vec_t){.c = calloc(GF2_WORDS(n), sizeof(uint64_t)), .n = n};
+}
+
+gf2_vec_t gf2_vec_new_copy(gf2_vec_t x)
+{
+    gf2_vec_t y = gf2_vec_new_empty(x.n);
+
+    memcpy(y.c, x.c, GF2_WORDS(x.n) * sizeof *y.c);
+
+    return y;
+}
+
+gf2_vec_t gf2_vec_new_view(gf2_vec_t x)
+{
+    return x;
+}
+
+void gf2_vec_del(gf2_vec_t x)
+{
+    free(x.c);
+}
+
+void gf2_vec_copy(gf2_vec_t *x, gf2_vec_t y)
+{
+    gf2_vec_del(*x);
+
+    *x = gf2_vec_new_copy(y);
+}
+
+void gf2_vec_move(gf2_vec_t *x, gf2_vec_t y)
+{
+    gf2_vec_del(*x);
+
+    *x = y;
+}
+
+bool gf2_vec_get(gf2_vec_t x, size_t i)
+{
+    return x.c[i / GF2_WORD_BITS] >> (i % GF2_WORD_BITS) & 1;
+}
+
+void gf2_vec_set(gf2_vec_t x, size_t i, bool b)
+{
+    uint64_t m = 1ULL << (i % GF2_WORD_BITS);
+
+    x.c[i / GF2_WORD_BITS] = (x.c[i / GF2_WORD_BITS] & ~m) | (m & -(uint64_t)b);
+}
+
+bool gf2_vec_is_zero(gf2_vec_t x)
+{
+    for (size_t i = 0; i < GF2_WORDS(x.n); ++i)
+        if (x.c[i])
+            return false;
+
+    return true;
+}
+
+gf2_vec_t gf2_vec_self_add(gf2_vec_t x, gf2_vec_t y)
+{
+    for (size_t i = 0; i < GF2_WORDS(x.n); ++i)
+        x.c[i] ^= y.c[i];
+
+    return x;
+}
+
+gf2_vec_t gf2_vec_add(gf2_vec_t x, gf2_vec_t y)
+{
+    return gf2_vec_self_add(gf2_vec_new_copy(x), y);
+}
+
+gf2_vec_t gf2_vec_self_hmul(gf2_vec_t x, gf2_vec_t y)
+{
+    for (size_t i = 0; i < GF2_WORDS(x.n); ++i)
+        x.c[i] &= y.c[i];
+
+    return x;
+}
+
+gf2_vec_t gf2_vec_hmul(gf2_vec_t x, gf2_vec_t y)
+{
+    return gf2_vec_self_hmul(gf2_vec_new_copy(x), y);
+}
+
+size_t gf2_vec_weight(gf2_vec_t x)
+{
+    size_t w = 0;
+
+    for (size_t i = 0; i < GF2_WORDS(x.n); ++i)
+        w += __builtin_popcountll(x.c[i]);
+
+    return w;
+}
+
+bool gf2_vec_dot(gf2_vec_t x, gf2_vec_t y)
+{
+    // Only the parity of the popcount matters, so the words can be folded first
+    uint64_t z = 0;
+
+    for (size_t i = 0; i < GF2_WORDS(x.n); ++i)
+        z ^= x.c[i] & y.c[i];
+
+    return __builtin_parityll(z);
+}
+
+gf2_vec_t gf2_vec_from_zp_vec(zp_vec_t x)
+{
+    gf2_vec_t y = gf2_vec_new(x.n);
+
+    for (size_t i = 0; i < x.n; ++i)
+        y.c[i / GF2_WORD_BITS] |= (x.c[i].v & 1) << (i % GF2_WORD_BITS);
+
+    return y;
+}
+
+zp_vec_t gf2_vec_to_zp_vec(gf2_vec_t x)
+{
+    zp_vec_t y = zp_vec_new_empty(x.n);
+
+    for (size_t i = 0; i < x.n; ++i)
+        y.c[i].v = gf2_vec_get(x, i);
+
+    return y;
+}
+
+void gf2_vec_print(FILE *f, gf2_vec_t x)
+{
+    fprintf(f, "[");
+
+    if (x.n > 0)
+        fprintf(f, "%d", gf2_vec_get(x, 0));
+
+    for (size_t i = 1; i < x.n; ++i)
+        fprintf(f, ", %d", gf2_vec_get(x, i));
+
+    fprintf(f, "]");
+}
@@ -1,16 +1,191 @@
+#include "oracle_stats.hpp"
+#include "prf.hpp"
 #include "span_utils.hpp"
 #include "string_utils.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <map>
+#include <mutex>
+#include <optional>
 #include <random>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <csignal>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <numeric>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
+// Rounds of the alternating Feistel network emulating the ideal cipher (half-block updates)
+static constexpr size_t PRP_ROUNDS = 24;
+
+// Hash of keys and blocks for the oracle tables
+struct BytesHash
+{
+    template<size_t sz>
+    size_t operator()(const std::array<uint8_t, sz> &x) const
+    {
+        return std::hash<std::string_view>{}({reinterpret_cast<const char *>(x.data()), sz});
+    }
+};
+
+// The sampled part of the permutation of a key, as one bidirectional store: a dense array of
+// the sampled (pln, cip) pairs, indexed by one open-addressed table per direction. The load factor
+// is kept in (1/4, 1/2], so each pair costs 2 * msg_sz bytes plus 16 to 32 bytes of index, instead
+// of two tree or list nodes.
+// Blocks of up to 16 bits have a small domain: once it is fully sampled, the permutation and its
+// inverse are materialized as plain arrays and the pairs are dropped.
+template<size_t msg_sz>
+class SampledPerm
+{
+public:
+    using Msg = std::array<uint8_t, msg_sz>;
+
+private:
+    static constexpr bool SMALL = msg_sz <= 2;
+    static constexpr size_t DOMAIN_SZ = SMALL ? 1ULL << (CHAR_BIT * msg_sz) : 0;
+    static constexpr size_t MIN_CAP = 16;
+
+    using Idx = uint32_t; // pair index + 1, 0 marks an empty slot
+
+    std::vector<std::array<Msg, 2>> pairs;
+    std::array<std::vector<Idx>, 2> idx;
+    std::array<std::vector<uint16_t>, 2> full;
+
+    static size_t to_int(const Msg &x)
+    {
+        size_t v = 0;
+
+        for (size_t i = 0; i < msg_sz; ++i)
+            v |= size_t(x[i]) << (CHAR_BIT * i);
+
+        return v;
+    }
+
+    static Msg from_int(size_t v)
+    {
+        Msg x;
+
+        for (size_t i = 0; i < msg_sz; ++i)
+            x[i] = static_cast<uint8_t>(v >> (CHAR_BIT * i));
+
+        return x;
+    }
+
+    Idx find(bool inv, const Msg &x) const
+    {
+        const auto &tab = idx[inv];
+
+        if (tab.empty())
+            return 0;
+
+        size_t mask = tab.size() - 1;
+
+        for (size_t i = BytesHash{}(x) & mask; tab[i]; i = (i + 1) & mask)
+            if (pairs[tab[i] - 1][inv] == x)
+                return tab[i];
+
+        return 0;
+    }
+
+    void link(bool inv, Idx r)
+    {
+        auto &tab = idx[inv];
+        size_t mask = tab.size() - 1;
+        size_t i = BytesHash{}(pairs[r - 1][inv]) & mask;
+
+        while (tab[i])
+            i = (i + 1) & mask;
+        tab[i] = r;
+    }
+
+    void add(const Msg &pln, const Msg &cip)
+    {
+        // Keep the load factor at most 1/2, doubling the tables brings it back above 1/4
+        if (2 * (pairs.size() + 1) > idx[0].size())
+        {
+            size_t cap = std::max(MIN_CAP, 2 * idx[0].size());
+
+            for (bool inv : {false, true})
+            {
+                idx[inv].assign(cap, 0);
+                for (size_t r = 1; r <= pairs.size(); ++r)
+                    link(inv, r);
+            }
+        }
+
+        pairs.push_back({pln, cip});
+        link(0, pairs.size());
+        link(1, pairs.size());
+
+        if constexpr (SMALL)
+            if (pairs.size() == DOMAIN_SZ)
+                materialize();
+    }
+
+    void materialize()
+    {
+        for (bool inv : {false, true})
+            full[inv].resize(DOMAIN_SZ);
+        for (auto &[pln, cip] : pairs)
+        {
+            full[0][to_int(pln)] = static_cast<uint16_t>(to_int(cip));
+            full[1][to_int(cip)] = static_cast<uint16_t>(to_int(pln));
+        }
+
+        pairs = {};
+        idx = {};
+    }
+
+public:
+    // Query forwards (inv = 0) or backwards (inv = 1), sampling a fresh image if needed. Looking
+    // it up in the opposite direction keeps the sampling bijective.
+    template<typename Rng>
+    Msg query(const Msg &x, bool inv, Rng &rng)
+    {
+        if (!full[inv].empty())
+            return from_int(full[inv][to_int(x)]);
+        if (Idx r = find(inv, x))
+            return pairs[r - 1][!inv];
+
+        Msg y;
+
+        do
+            std::ranges::generate(y, std::ref(rng));
+        while (find(!inv, y));
+
+        if (inv)
+            add(y, x);
+        else
+            add(x, y);
+
+        return y;
+    }
+
+    void insert(const Msg &pln, const Msg &cip)
+    {
+        if (full[0].empty() && !find(0, pln))
+            add(pln, cip);
+    }
+
+    size_t size() const { return full[0].empty() ? pairs.size() : DOMAIN_SZ; }
+};
 
 template<size_t key_sz = 16, size_t msg_sz = key_sz>
 class IdealCipher
@@ -25,112 +200,904 @@ public:
     using MsgS = std::span<const uint8_t, MSG_SIZE>;
 
 private:
-    static inline std::map<Key, std::pair<std::map<Msg, Msg>, std::map<Msg, Msg>>> table;
-    static inline std::random_device rng;
+    static inline std::unordered_map<Key, SampledPerm<MSG_SIZE>, BytesHash> table;
+    static inline std::mt19937_64 rng{std::random_device{}()};
+
+    static Msg query(KeyS key, MsgS x_v, bool inv)
+    {
+        auto &perm = table.try_emplace(range_from_span<Key>(key)).first->second;
+
+        return perm.query(range_from_span<Msg>(x_v), inv, rng);
+    }
 
 public:
+    static inline OracleStats enc_stats{"IdealCipher::encrypt"};
+    static inline OracleStats dec_stats{"IdealCipher::decrypt"};
+
     static Msg encrypt(KeyS key, MsgS pln_v)
     {
-        Msg pln{range_from_span<Msg>(pln_v)};
-        auto &[pln_tab, cip_tab] = table.try_emplace(range_from_span<Key>(key)).first->second;
+        OracleStats::Probe probe{enc_stats};
+
+        return query(key, pln_v, 0);
+    }
 
-        if (pln_tab.contains(pln))
-            return pln_tab[pln];
+    static Msg decrypt(KeyS key, MsgS cip_v)
+    {
+        OracleStats::Probe probe{dec_stats};
 
-        Msg cip;
+        return query(key, cip_v, 1);
+    }
 
-        do
-            std::ranges::generate(cip, std::ref(rng));
-        while (std::ranges::any_of(pln_tab, [&](auto &&pair) { return pair.second == cip; }));
+    IdealCipher() = delete;
+};
 
-        pln_tab.emplace(pln, cip);
-        cip_tab.emplace(cip, pln);
+// Thread-safe IdealCipher with the same interface. Keys are spread over independently locked
+// shards and every thread samples from its own RNG stream, so threads only contend when they
+// query keys of the same shard at the same time.
+template<size_t key_sz = 16, size_t msg_sz = key_sz>
+class ConcurrentIdealCipher
+{
+public:
+    static constexpr size_t KEY_SIZE = key_sz;
+    static constexpr size_t MSG_SIZE = msg_sz;
+    static constexpr size_t SHARDS = 64;
 
-        return cip;
+    using Key = std::array<uint8_t, KEY_SIZE>;
+    using Msg = std::array<uint8_t, MSG_SIZE>;
+    using KeyS = std::span<const uint8_t, KEY_SIZE>;
+    using MsgS = std::span<const uint8_t, MSG_SIZE>;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::mutex mtx;
+        std::unordered_map<Key, SampledPerm<MSG_SIZE>, BytesHash> table;
+        std::vector<std::tuple<Key, Msg, Msg>> fresh; // sampled since the last drain()
+    };
+
+    static inline std::array<Shard, SHARDS> shards;
+
+    static std::mt19937_64 &local_rng()
+    {
+        static thread_local std::mt19937_64 rng{std::random_device{}()};
+
+        return rng;
     }
 
-    static Msg decrypt(KeyS key, MsgS cip_v)
+    static Msg query(KeyS key_v, MsgS x_v, bool inv)
     {
-        Msg cip{range_from_span<Msg>(cip_v)};
+        Key key{range_from_span<Key>(key_v)};
+        Msg x{range_from_span<Msg>(x_v)};
+        Shard &shard = shards[BytesHash{}(key) % SHARDS];
+        std::lock_guard lock{shard.mtx};
+        auto &perm = shard.table[key];
+        size_t n = perm.size();
+        Msg y = perm.query(x, inv, local_rng());
 
-        auto &[pln_tab, cip_tab] = table.try_emplace(range_from_span<Key>(key)).first->second;
+        if (perm.size() != n)
+            shard.fresh.emplace_back(key, inv ? y : x, inv ? x : y);
 
-        if (cip_tab.contains(cip))
-            return cip_tab[cip];
+        return y;
+    }
 
-        Msg pln;
+public:
+    static inline OracleStats enc_stats{"ConcurrentIdealCipher::encrypt"};
+    static inline OracleStats dec_stats{"ConcurrentIdealCipher::decrypt"};
 
-        do
-            std::ranges::generate(pln, std::ref(rng));
-        while (std::ranges::any_of(cip_tab, [&](auto &&pair) { return pair.second == pln; }));
+    static Msg encrypt(KeyS key, MsgS pln_v)
+    {
+        OracleStats::Probe probe{enc_stats};
 
-        cip_tab.emplace(cip, pln);
-        pln_tab.emplace(pln, cip);
+        return query(key, pln_v, 0);
+    }
 
-        return pln;
+    static Msg decrypt(KeyS key, MsgS cip_v)
+    {
+        OracleStats::Probe probe{dec_stats};
+
+        return query(key, cip_v, 1);
     }
 
-    static void dump_state(std::ofstream &fs)
+    // Record a pair sampled elsewhere, e.g. loaded from a store
+    static void insert(KeyS key_v, MsgS pln_v, MsgS cip_v)
     {
-        size_t sz = table.size();
+        Key key{range_from_span<Key>(key_v)};
+        Shard &shard = shards[BytesHash{}(key) % SHARDS];
+        std::lock_guard lock{shard.mtx};
 
-        fs.write(reinterpret_cast<const char *>(&sz), sizeof(sz));
-        for (auto &[key, pair] : table)
-        {
-            auto &pln_tab = pair.first;
+        shard.table[key].insert(range_from_span<Msg>(pln_v), range_from_span<Msg>(cip_v));
+    }
 
-            fs.write(reinterpret_cast<const char *>(key.data()), key.size());
+    // Call f(key, pln, cip) on every pair sampled since the last call, e.g. to store it
+    template<typename F>
+    static void drain(F &&f)
+    {
+        for (auto &shard : shards)
+        {
+            std::vector<std::tuple<Key, Msg, Msg>> fresh;
 
-            sz = pln_tab.size();
-            fs.write(reinterpret_cast<const char *>(&sz), sizeof(sz));
-            for (auto &[pln, cip] : pln_tab)
             {
-                fs.write(reinterpret_cast<const char *>(pln.data()), pln.size());
-                fs.write(reinterpret_cast<const char *>(cip.data()), cip.size());
+                std::lock_guard lock{shard.mtx};
+                fresh.swap(shard.fresh);
             }
+
+            for (auto &[key, pln, cip] : fresh)
+                f(key, pln, cip);
         }
     }
 
-    static void dump_state(std::ofstream &&fs) { dump_state(fs); }
+    ConcurrentIdealCipher() = delete;
+};
+
+// Stateless emulation of IdealCipher: for every key, a seeded alternating Feistel network with a
+// PRF round function acts as a small-domain PRP, so both directions need no table
+template<size_t key_sz = 16, size_t msg_sz = key_sz>
+class PrfCipher
+{
+    static_assert(msg_sz >= 2, "The Feistel network needs at least one byte per half!");
+
+public:
+    static constexpr size_t KEY_SIZE = key_sz;
+    static constexpr size_t MSG_SIZE = msg_sz;
+
+    using Key = std::array<uint8_t, KEY_SIZE>;
+    using Msg = std::array<uint8_t, MSG_SIZE>;
+    using KeyS = std::span<const uint8_t, KEY_SIZE>;
+    using MsgS = std::span<const uint8_t, MSG_SIZE>;
+
+private:
+    static constexpr size_t L_SZ = MSG_SIZE / 2;
+    static constexpr size_t R_SZ = MSG_SIZE - L_SZ;
+
+    static inline Prf prf{0};
+
+    // Round i xors F(i, key, other half) into the left half if i is even, the right one if odd
+    static void feistel_round(Msg &x, KeyS key, size_t i)
+    {
+        std::array<uint8_t, KEY_SIZE + R_SZ> in{};
+        std::array<uint8_t, R_SZ> f;
+        bool even = i % 2 == 0;
+        std::span<uint8_t> src = even ? std::span{x}.subspan(L_SZ) : std::span{x}.first(L_SZ);
+        std::span<uint8_t> dst = even ? std::span{x}.first(L_SZ) : std::span{x}.subspan(L_SZ);
+
+        std::ranges::copy(key, in.begin());
+        std::ranges::copy(src, in.begin() + KEY_SIZE);
+        prf.eval(std::span{f}.first(dst.size()), std::span{in}.first(KEY_SIZE + src.size()), i);
+
+        for (size_t j = 0; j < dst.size(); ++j)
+            dst[j] ^= f[j];
+    }
+
+public:
+    static inline OracleStats enc_stats{"PrfCipher::encrypt"};
+    static inline OracleStats dec_stats{"PrfCipher::decrypt"};
+
+    static void set_seed(uint64_t seed) { prf = Prf{seed}; }
+
+    static Msg encrypt(KeyS key, MsgS pln_v)
+    {
+        OracleStats::Probe probe{enc_stats};
+        Msg x{range_from_span<Msg>(pln_v)};
+
+        for (size_t i = 0; i < PRP_ROUNDS; ++i)
+            feistel_round(x, key, i);
+
+        return x;
+    }
+
+    static Msg decrypt(KeyS key, MsgS cip_v)
+    {
+        OracleStats::Probe probe{dec_stats};
+        Msg x{range_from_span<Msg>(cip_v)};
+
+        for (size_t i = PRP_ROUNDS; i-- > 0;)
+            feistel_round(x, key, i);
+
+        return x;
+    }
+
+    PrfCipher() = delete;
+};
+
+// Persistent IdealCipher: an append-only log of the sampled (key, pln, cip) triples, plus an
+// open-addressed hash index of the log mapped in memory. The log alone is the state: the index
+// is rebuilt from it on open when missing or stale, and only the records appended since it was
+// last synced are indexed. A query costs O(1) disk operations, however large the state. As in
+// SampledPerm, every pair is stored once and indexed in both directions, by two 8-byte slots.
+//
+// New records are buffered and written out at checkpoints: by sync(), every SYNC_RECS records
+// and on destruction. Records not yet synced are lost if the process dies.
+template<size_t key_sz = 16, size_t msg_sz = key_sz>
+class IdealCipherStore
+{
+public:
+    static constexpr size_t KEY_SIZE = key_sz;
+    static constexpr size_t MSG_SIZE = msg_sz;
+
+    using Key = std::array<uint8_t, KEY_SIZE>;
+    using Msg = std::array<uint8_t, MSG_SIZE>;
+    using KeyS = std::span<const uint8_t, KEY_SIZE>;
+    using MsgS = std::span<const uint8_t, MSG_SIZE>;
+
+private:
+    // Log record: [key | pln | cip]
+    static constexpr size_t REC_SZ = KEY_SIZE + 2 * MSG_SIZE;
+    static constexpr size_t READ_RECS = 1 << 12;
+    static constexpr size_t SYNC_RECS = 1 << 16;
+
+    // Index slot: 16-bit hash tag | 48-bit reference 2 * record + direction + 1 (0 = empty)
+    static constexpr size_t TAG_SHIFT = 48;
+    static constexpr uint64_t REF_MASK = (1ULL << TAG_SHIFT) - 1;
+    static constexpr size_t IDX_MIN_CAP = 1 << 12;
+    static constexpr uint64_t IDX_MAGIC = 0x317864692d636469; // "idc-idx1"
+
+    using Rec = std::array<uint8_t, REC_SZ>;
+
+    struct IdxHeader
+    {
+        uint64_t magic;
+        uint64_t rec_sz;
+        uint64_t cap;
+        uint64_t n; // records of the log covered by the index
+    };
+
+    std::string log_path;
+    std::string idx_path;
+    int log_fd = -1;
+    size_t log_n = 0; // records written to the log, the rest are pending
+    std::vector<Rec> pending;
+    int idx_fd = -1;
+    IdxHeader *idx = nullptr;
+    uint64_t *slots = nullptr;
+    size_t map_sz = 0;
+    std::mt19937_64 rng{std::random_device{}()};
+
+    [[noreturn]] static void die(const std::string &what)
+    {
+        std::cerr << what << ": " << std::strerror(errno) << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Hash of (key | x), tweaked by the direction of the query
+    static uint64_t slot_hash(bool inv, const Key &key, const Msg &x)
+    {
+        std::array<uint8_t, KEY_SIZE + MSG_SIZE> kx;
+
+        std::ranges::copy(key, kx.begin());
+        std::ranges::copy(x, kx.begin() + KEY_SIZE);
+
+        return BytesHash{}(kx) ^ (inv ? 0x9e3779b97f4a7c15ULL : 0);
+    }
+
+    Rec read_rec(size_t r) const
+    {
+        if (r >= log_n)
+            return pending[r - log_n];
+
+        Rec rec;
+
+        if (pread(log_fd, rec.data(), REC_SZ, r * REC_SZ) != REC_SZ)
+            die(log_path);
+
+        return rec;
+    }
+
+    void insert(size_t r, const Rec &rec)
+    {
+        Key key{range_from_span<Key>(std::span{rec}.template first<KEY_SIZE>())};
 
-    static void load_state(std::ifstream &fs)
+        for (bool inv : {false, true})
+        {
+            auto x_v = std::span{rec}.subspan(KEY_SIZE + inv * MSG_SIZE).template first<MSG_SIZE>();
+            Msg x{range_from_span<Msg>(x_v)};
+            uint64_t h = slot_hash(inv, key, x);
+            size_t i = h & (idx->cap - 1);
+
+            while (slots[i])
+                i = (i + 1) & (idx->cap - 1);
+            slots[i] = (h >> TAG_SHIFT) << TAG_SHIFT | (2 * r + inv + 1);
+        }
+    }
+
+    // Index the log records in [idx->n, n_log)
+    void index_tail(size_t n_log)
     {
-        size_t sz = 0;
+        std::vector<Rec> buf(READ_RECS);
 
-        fs.read(reinterpret_cast<char *>(&sz), sizeof(sz));
-        for (size_t i = 0; i < sz; ++i)
+        while (idx->n < n_log)
         {
-            Key key{};
-            fs.read(reinterpret_cast<char *>(key.data()), key.size());
+            size_t n = std::min(n_log - idx->n, READ_RECS);
 
-            auto &[pln_tab, cip_tab] = table.try_emplace(key).first->second;
+            if (pread(log_fd, buf.data(), n * REC_SZ, idx->n * REC_SZ) != ssize_t(n * REC_SZ))
+                die(log_path);
+            for (size_t i = 0; i < n; ++i)
+                insert(idx->n + i, buf[i]);
+            idx->n += n;
+        }
+    }
 
-            fs.read(reinterpret_cast<char *>(&sz), sizeof(sz));
-            for (size_t j = 0; j < sz; ++j)
+    void unmap_index()
+    {
+        if (idx)
+            munmap(idx, map_sz);
+        idx = nullptr;
+        slots = nullptr;
+    }
+
+    void map_index(size_t sz)
+    {
+        void *p = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, idx_fd, 0);
+
+        if (p == MAP_FAILED)
+            die(idx_path);
+
+        map_sz = sz;
+        idx = static_cast<IdxHeader *>(p);
+        slots = reinterpret_cast<uint64_t *>(idx + 1);
+    }
+
+    // Throw the index away and rebuild it from the first n_log records of the log
+    void rebuild_index(size_t cap, size_t n_log)
+    {
+        size_t sz = sizeof(IdxHeader) + cap * sizeof(uint64_t);
+
+        unmap_index();
+        if (ftruncate(idx_fd, 0) || ftruncate(idx_fd, sz))
+            die(idx_path);
+
+        map_index(sz);
+        *idx = {IDX_MAGIC, REC_SZ, cap, 0};
+        index_tail(n_log);
+    }
+
+    std::optional<Msg> lookup(bool inv, const Key &key, const Msg &x) const
+    {
+        uint64_t h = slot_hash(inv, key, x);
+
+        for (size_t i = h & (idx->cap - 1); slots[i]; i = (i + 1) & (idx->cap - 1))
+        {
+            uint64_t ref = (slots[i] & REF_MASK) - 1;
+
+            if (slots[i] >> TAG_SHIFT != h >> TAG_SHIFT || (ref & 1) != inv)
+                continue;
+
+            Rec rec{read_rec(ref >> 1)};
+            auto in = std::span{rec}.subspan(KEY_SIZE + inv * MSG_SIZE, MSG_SIZE);
+            auto out = std::span{rec}.subspan(KEY_SIZE + !inv * MSG_SIZE, MSG_SIZE);
+
+            if (std::ranges::equal(std::span{rec}.first(KEY_SIZE), key) &&
+                std::ranges::equal(in, x))
+                return range_from_span<Msg>(out.template first<MSG_SIZE>());
+        }
+
+        return std::nullopt;
+    }
+
+    void append(const Key &key, const Msg &pln, const Msg &cip)
+    {
+        Rec rec;
+
+        std::ranges::copy(key, rec.begin());
+        std::ranges::copy(pln, rec.begin() + KEY_SIZE);
+        std::ranges::copy(cip, rec.begin() + KEY_SIZE + MSG_SIZE);
+
+        // Keep the load factor (two slots per record) below 1/2
+        if (4 * (idx->n + 1) > idx->cap)
+        {
+            sync();
+            rebuild_index(2 * idx->cap, idx->n);
+        }
+
+        pending.emplace_back(rec);
+        insert(idx->n, rec);
+        ++idx->n;
+
+        if (pending.size() >= SYNC_RECS)
+            sync();
+    }
+
+    Msg query(KeyS key_v, MsgS x_v, bool inv)
+    {
+        Key key{range_from_span<Key>(key_v)};
+        Msg x{range_from_span<Msg>(x_v)};
+
+        if (auto y = lookup(inv, key, x))
+            return *y;
+
+        Msg y;
+
+        do
+            std::ranges::generate(y, std::ref(rng));
+        while (lookup(!inv, key, y));
+
+        if (inv)
+            append(key, y, x);
+        else
+            append(key, x, y);
+
+        return y;
+    }
+
+public:
+    static inline OracleStats enc_stats{"IdealCipherStore::encrypt"};
+    static inline OracleStats dec_stats{"IdealCipherStore::decrypt"};
+
+    IdealCipherStore(std::string log, std::string index)
+        : log_path{std::move(log)}, idx_path{std::move(index)}
+    {
+        struct stat st;
+
+        log_fd = open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        idx_fd = open(idx_path.c_str(), O_RDWR | O_CREAT, 0644);
+        // One process at a time: others wait here until this one is done
+        if (log_fd < 0 || flock(log_fd, LOCK_EX) || fstat(log_fd, &st))
+            die(log_path);
+        if (idx_fd < 0)
+            die(idx_path);
+
+        // Drop a torn record left by an interrupted append
+        size_t n_log = st.st_size / REC_SZ;
+
+        if (size_t(st.st_size) != n_log * REC_SZ && ftruncate(log_fd, n_log * REC_SZ))
+            die(log_path);
+        log_n = n_log;
+
+        size_t cap = std::max(IDX_MIN_CAP, std::bit_ceil(4 * n_log + 4));
+        IdxHeader hdr{};
+
+        if (fstat(idx_fd, &st))
+            die(idx_path);
+
+        bool valid = size_t(st.st_size) >= sizeof(hdr) &&
+                     pread(idx_fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+                     hdr.magic == IDX_MAGIC && hdr.rec_sz == REC_SZ &&
+                     std::has_single_bit(hdr.cap) && hdr.n <= n_log &&
+                     size_t(st.st_size) == sizeof(hdr) + hdr.cap * sizeof(uint64_t);
+
+        if (!valid || 4 * n_log > hdr.cap)
+        {
+            rebuild_index(cap, n_log);
+        }
+        else
+        {
+            map_index(st.st_size);
+            index_tail(n_log);
+        }
+    }
+
+    IdealCipherStore(const IdealCipherStore &) = delete;
+
+    ~IdealCipherStore()
+    {
+        sync();
+        unmap_index();
+        close(idx_fd);
+        close(log_fd);
+    }
+
+    // Number of sampled pairs, over all keys
+    size_t size() const { return idx->n; }
+
+    // Call f(key, pln, cip) on every sampled pair, in the order they were sampled
+    template<typename F>
+    void for_each(F &&f)
+    {
+        std::vector<Rec> buf(READ_RECS);
+
+        sync();
+        for (size_t r = 0; r < log_n; r += READ_RECS)
+        {
+            size_t n = std::min(log_n - r, READ_RECS);
+
+            if (pread(log_fd, buf.data(), n * REC_SZ, r * REC_SZ) != ssize_t(n * REC_SZ))
+                die(log_path);
+            for (size_t i = 0; i < n; ++i)
             {
-                Msg pln{}, cip{};
+                auto rec = std::span{buf[i]};
 
-                fs.read(reinterpret_cast<char *>(pln.data()), pln.size());
-                fs.read(reinterpret_cast<char *>(cip.data()), cip.size());
+                f(rec.template first<KEY_SIZE>(), rec.template subspan<KEY_SIZE, MSG_SIZE>(),
+                  rec.template subspan<KEY_SIZE + MSG_SIZE, MSG_SIZE>());
+            }
+        }
+    }
+
+    // Record a pair sampled elsewhere, unless the key already maps pln or cip
+    void add(KeyS key_v, MsgS pln_v, MsgS cip_v)
+    {
+        Key key{range_from_span<Key>(key_v)};
+        Msg pln{range_from_span<Msg>(pln_v)};
+        Msg cip{range_from_span<Msg>(cip_v)};
+
+        if (!lookup(0, key, pln) && !lookup(1, key, cip))
+            append(key, pln, cip);
+    }
 
-                pln_tab.emplace(pln, cip);
-                cip_tab.emplace(cip, pln);
+    // Checkpoint: append the pending records to the log
+    void sync()
+    {
+        const uint8_t *p = reinterpret_cast<const uint8_t *>(pending.data());
+
+        for (size_t left = pending.size() * REC_SZ; left > 0;)
+        {
+            ssize_t w = write(log_fd, p, left);
+
+            if (w < 0 && errno != EINTR)
+                die(log_path);
+            if (w > 0)
+            {
+                p += w;
+                left -= w;
             }
         }
+
+        log_n += pending.size();
+        pending.clear();
     }
 
-    static void load_state(std::ifstream &&fs) { load_state(fs); }
+    Msg encrypt(KeyS key, MsgS pln_v)
+    {
+        OracleStats::Probe probe{enc_stats};
 
-    IdealCipher() = delete;
+        return query(key, pln_v, 0);
+    }
+
+    Msg decrypt(KeyS key, MsgS cip_v)
+    {
+        OracleStats::Probe probe{dec_stats};
+
+        return query(key, cip_v, 1);
+    }
 };
 
+// Import the state file of older versions, [n_keys | (key | n_pairs | (pln | cip)...)...], into
+// an empty log, then rename it so that it is imported once. If the log already holds a state, the
+// file is left alone.
+template<typename Store>
+static void import_dat(Store &store, const char *path)
+{
+    using Key = typename Store::Key;
+    using Msg = typename Store::Msg;
+
+    std::ifstream fs{path, std::ios::binary};
+
+    if (!fs)
+        return;
+    if (store.size() > 0)
+    {
+        std::cerr << "Warning: ignoring " << path << ", the log already holds a state\n";
+        return;
+    }
+
+    auto read = [&](auto &x) { fs.read(reinterpret_cast<char *>(&x), sizeof(x)); };
+    std::vector<std::tuple<Key, Msg, Msg>> recs;
+    size_t n_keys = 0;
+
+    // An empty file is an empty state
+    if (fs.peek() != std::ifstream::traits_type::eof())
+        read(n_keys);
+    for (size_t i = 0; fs && i < n_keys; ++i)
+    {
+        Key key{};
+        size_t n = 0;
+
+        read(key);
+        read(n);
+        for (size_t j = 0; fs && j < n; ++j)
+        {
+            Msg pln{}, cip{};
+
+            read(pln);
+            read(cip);
+            recs.emplace_back(key, pln, cip);
+        }
+    }
+
+    if (!fs)
+    {
+        std::cerr << path << ": truncated state file, not imported\n";
+        exit(EXIT_FAILURE);
+    }
+
+    for (auto &[key, pln, cip] : recs)
+        store.add(key, pln, cip);
+    store.sync();
+
+    std::string done = std::string{path} + ".imported";
+
+    if (std::rename(path, done.c_str()))
+        std::cerr << path << ": " << std::strerror(errno) << "\n";
+    std::cerr << "Imported " << store.size() << " pairs from " << path << "\n";
+}
+
+// Size of the request buffer of the server, longer lines are rejected
+static constexpr size_t SERVE_BUF_SZ = 1 << 16;
+
+static std::atomic<bool> serve_stop{false};
+
+static_assert(std::atomic<bool>::is_always_lock_free, "serve_stop is set by a signal handler!");
+
+// Serve newline-delimited requests "<b> <key> <msg>" read from `in_fd`, writing one hex line per
+// request to `out_fd` ("error" if malformed), in order. A "sync" request checkpoints the state
+// and is answered "ok". Requests are parsed in bulk and the answers to a whole read are written
+// at once, so clients can pipeline as many requests as they like.
+template<typename Cipher, typename Oracle, typename Sync>
+static void serve(int in_fd, int out_fd, Oracle &&oracle, Sync &&sync)
+{
+    using Key = typename Cipher::Key;
+    using Msg = typename Cipher::Msg;
+
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    std::vector<char> buf(SERVE_BUF_SZ + 1);
+    std::string out;
+    size_t len = 0;
+    bool skip = false; // dropping the rest of an overlong line
+
+    auto answer = [&](char *line)
+    {
+        char *save = nullptr;
+        char *tok[4]{};
+
+        for (size_t i = 0; i < 4; ++i)
+            tok[i] = strtok_r(i ? nullptr : line, " \t\r", &save);
+
+        if (!tok[0])
+            return;
+        if (!std::strcmp(tok[0], "sync") && !tok[1])
+        {
+            sync();
+            out += "ok\n";
+            return;
+        }
+        if (!tok[2] || tok[3] || std::strlen(tok[0]) != 1 || (*tok[0] != '0' && *tok[0] != '1'))
+        {
+            out += "error\n";
+            return;
+        }
+
+        Key key{};
+        Msg msg{};
+
+        hexload(key.data(), key.size(), tok[1]);
+        hexload(msg.data(), msg.size(), tok[2]);
+
+        Msg res = oracle(*tok[0] == '1', key, msg);
+
+        for (uint8_t x : res)
+        {
+            out += HEX[x >> 4];
+            out += HEX[x & 15];
+        }
+        out += '\n';
+    };
+
+    while (!serve_stop)
+    {
+        ssize_t r = read(in_fd, buf.data() + len, SERVE_BUF_SZ - len);
+
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+
+        char *p = buf.data();
+        char *end = p + len + r;
+
+        // The overlong line was already answered "error", resume after its end
+        if (skip)
+        {
+            char *nl = std::find(p, end, '\n');
+
+            skip = nl == end;
+            p = skip ? end : nl + 1;
+        }
+
+        for (char *nl; (nl = std::find(p, end, '\n')) != end; p = nl + 1)
+        {
+            *nl = '\0';
+            answer(p);
+        }
+
+        len = end - p;
+        std::memmove(buf.data(), p, len);
+        if (len == SERVE_BUF_SZ)
+        {
+            out += "error\n";
+            len = 0;
+            skip = true;
+        }
+
+        for (size_t off = 0; off < out.size();)
+        {
+            ssize_t w = write(out_fd, out.data() + off, out.size() - off);
+
+            if (w < 0 && errno != EINTR)
+                break;
+            if (w > 0)
+                off += w;
+        }
+        out.clear();
+    }
+
+    sync();
+}
+
+// Serve the clients of the listening socket `fd` from `threads` worker threads, until interrupted.
+// The calling thread takes the signals and then wakes the workers up by shutting the sockets down.
+template<typename Cipher, typename Oracle, typename Sync>
+static void serve_pool(int fd, size_t threads, Oracle &oracle, Sync &sync)
+{
+    std::mutex mtx;
+    std::vector<int> conns; // open connections
+    bool closing = false;
+    std::vector<std::thread> workers;
+    sigset_t sigs, old_sigs;
+
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, &old_sigs);
+
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back(
+            [&]
+            {
+                for (;;)
+                {
+                    int conn = accept(fd, nullptr, nullptr);
+
+                    {
+                        std::lock_guard lock{mtx};
+
+                        if (closing)
+                        {
+                            if (conn >= 0)
+                                close(conn);
+                            break;
+                        }
+                        if (conn < 0)
+                            continue;
+                        conns.push_back(conn);
+                    }
+
+                    serve<Cipher>(conn, conn, oracle, sync);
+
+                    {
+                        std::lock_guard lock{mtx};
+                        std::erase(conns, conn);
+                    }
+                    close(conn);
+                }
+            });
+
+    while (!serve_stop)
+        sigsuspend(&old_sigs);
+    pthread_sigmask(SIG_SETMASK, &old_sigs, nullptr);
+
+    {
+        std::lock_guard lock{mtx};
+
+        closing = true;
+        shutdown(fd, SHUT_RDWR);
+        for (int conn : conns)
+            shutdown(conn, SHUT_RDWR);
+    }
+
+    for (auto &w : workers)
+        w.join();
+}
+
+// Serve stdin/stdout, or the clients of the Unix socket at `path`, `threads` at a time, until
+// interrupted. With more than one thread, the oracle and sync must be thread-safe.
+template<typename Cipher, typename Oracle, typename Sync>
+static int run_server(const char *path, size_t threads, Oracle &&oracle, Sync &&sync)
+{
+    struct sigaction sa{};
+
+    // No SA_RESTART, so that a blocking read of stdin returns on SIGINT/SIGTERM
+    sa.sa_handler = [](int) { serve_stop = true; };
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (!path)
+    {
+        serve<Cipher>(STDIN_FILENO, STDOUT_FILENO, oracle, sync);
+        return 0;
+    }
+
+    sockaddr_un addr{};
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+        listen(fd, SOMAXCONN))
+    {
+        std::cerr << path << ": " << std::strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    serve_pool<Cipher>(fd, threads, oracle, sync);
+
+    close(fd);
+    unlink(path);
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
-    using E = IdealCipher<8>;
+    using E = IdealCipherStore<8>;
+    using P = PrfCipher<8>;
+    using C = ConcurrentIdealCipher<8>;
+
+    if (argc > 1 && std::string_view{argv[1]} == "serve")
+    {
+        std::vector<const char *> args;
+        size_t threads = 1;
+
+        for (int i = 2; i < argc; ++i)
+            if (std::string_view{argv[i]} == "--threads" && i + 1 < argc)
+                threads = std::max(1ULL, std::stoull(argv[++i], nullptr, 0));
+            else
+                args.push_back(argv[i]);
+
+        const char *path = args.size() > 0 && std::string_view{args[0]} != "-" ? args[0] : nullptr;
+
+        if (!path && threads > 1)
+        {
+            std::cerr << "--threads needs a socket\n";
+            exit(EXIT_FAILURE);
+        }
+
+        if (args.size() > 1)
+        {
+            P::set_seed(std::stoull(args[1], nullptr, 0));
+
+            return run_server<P>(
+                path, threads,
+                [](bool b, const P::Key &key, const P::Msg &msg)
+                { return b ? P::decrypt(key, msg) : P::encrypt(key, msg); },
+                [] {});
+        }
+
+        E store{"ideal_cipher.log", "ideal_cipher.idx"};
+
+        import_dat(store, "ideal_cipher.dat");
+
+        if (threads == 1)
+            return run_server<E>(
+                path, threads,
+                [&](bool b, const E::Key &key, const E::Msg &msg)
+                { return b ? store.decrypt(key, msg) : store.encrypt(key, msg); },
+                [&] { store.sync(); });
+
+        // The store is not thread-safe: load the state in memory, answer from the concurrent
+        // tables and write the pairs sampled meanwhile back to the store at every checkpoint
+        std::mutex store_mtx;
+
+        store.for_each([](auto key, auto pln, auto cip) { C::insert(key, pln, cip); });
+
+        return run_server<C>(
+            path, threads,
+            [](bool b, const C::Key &key, const C::Msg &msg)
+            { return b ? C::decrypt(key, msg) : C::encrypt(key, msg); },
+            [&]
+            {
+                std::lock_guard lock{store_mtx};
+
+                C::drain([&](auto &key, auto &pln, auto &cip) { store.add(key, pln, cip); });
+                store.sync();
+            });
+    }
 
     if (argc < 4)
     {
-        std::cerr << "Usage: " << argv[0] << "<b> <key> <msg>\n";
+        std::cerr << "Usage: " << argv[0] << " <b> <key> <msg> [seed]\n";
+        std::cerr << "       " << argv[0] << " serve [socket|-] [seed] [--threads n]\n";
         exit(EXIT_FAILURE);
     }
 
@@ -141,13 +1108,25 @@ int main(int argc, char **argv)
     hexload(key.data(), key.size(), argv[2]);
     hexload(msg.data(), msg.size(), argv[3]);
 
-    E::load_state(std::ifstream{"ideal_cipher.dat", std::ios::binary});
+    // With a seed, answer from the stateless emulation and leave the state file alone
+    if (argc > 4)
+    {
+        P::set_seed(std::stoull(argv[4], nullptr, 0));
 
-    E::Msg cip = b ? E::decrypt(key, msg) : E::encrypt(key, msg);
+        P::Msg cip = b ? P::decrypt(key, msg) : P::encrypt(key, msg);
 
-    hexprint(stdout, cip.data(), cip.size());
+        hexprint(stdout, cip.data(), cip.size());
 
-    E::dump_state(std::ofstream{"ideal_cipher.dat", std::ios::binary});
+        return 0;
+    }
+
+    E store{"ideal_cipher.log", "ideal_cipher.idx"};
+
+    import_dat(store, "ideal_cipher.dat");
+
+    E::Msg cip = b ? store.decrypt(key, msg) : store.encrypt(key, msg);
+
+    hexprint(stdout, cip.data(), cip.size());
 
     return 0;
 }
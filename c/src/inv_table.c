@@ -27,17 +27,22 @@ int main(int argc, char **argv)
     fq_print(stdout, x);
     putchar('\n');
 
+    // Consecutive powers: one product each rather than a full exponentiation
+    fq_t y = fq_one();
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(r, p);
+
     for (uint64_t i = 0; i <= q; ++i)
     {
-        fq_t y = fq_pow(x, i, r, p);
-
         printf("x^%" PRIu64 " = ", i);
         fq_print(stdout, y);
         putchar('\n');
 
-        fq_del(y);
+        y = fq_self_mul_ctx(y, x, &ctx);
     }
 
+    fq_del(y);
+    zp_poly_rem_ctx_del(ctx);
+
     fq_del(x);
     zp_poly_del(r);
 
@@ -1,10 +1,27 @@
+#include "compression.hpp"
+#include "oracle_stats.hpp"
+#include "prf.hpp"
+#include "rand.h"
 #include "string_utils.hpp"
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <map>
+#include <mutex>
+#include <omp.h>
+#include <optional>
 #include <print>
+#include <queue>
 #include <random>
 #include <ranges>
 #include <span>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 
@@ -21,7 +38,29 @@ static constexpr size_t H2_PATH_LN = OUT_BITS / 2;
 static constexpr size_t H2_PATH_N = 1ULL << H2_PATH_LN;
 static constexpr size_t H2_EXPQ = H1_CHAIN_N * (1ULL << (OUT_BITS / 2));
 
-static size_t total_queries = 0;
+static constexpr size_t COLL_BATCH = 1ULL << 8;
+
+// Digests at least this wide are searched for collisions with the external-memory sort
+static constexpr size_t EXT_COLL_BITS = 40;
+// Records per sorted run spilled to disk (and per-run read buffer during the merge)
+static constexpr size_t EXT_RUN_SZ = 1ULL << 24;
+static constexpr size_t EXT_READ_SZ = 1ULL << 16;
+// Records per run when the external search is forced on narrower digests, so that it spills and
+// merges many runs
+static constexpr size_t EXT_FORCE_RUN_SZ = 1ULL << 6;
+
+// Herding: the diamond has 2^HERD_K leaves, linking a prefix costs about 2^(n - HERD_K) queries
+static constexpr size_t HERD_K = OUT_BITS / 2;
+static constexpr size_t HERD_PREFIX_N = 4;
+
+// Second preimage: the target is 2^SECPRE_LOG_LEN blocks long, bridging costs ~2^(n - log_len)
+static constexpr size_t SECPRE_LOG_LEN = OUT_BITS * 5 / 8;
+static constexpr size_t SECPRE_EXPQ = (1ULL << (OUT_BITS - SECPRE_LOG_LEN)) +
+                                      (1ULL << SECPRE_LOG_LEN) * 2 +
+                                      SECPRE_LOG_LEN * (1ULL << (OUT_BITS / 2));
+
+// Seed of the stateless ideal compression emulation, fixed for reproducible runs
+static constexpr uint64_t PRF_SEED = 0x5c2024;
 
 template<size_t msg_sz, size_t dig_sz>
 class IdealCompression
@@ -38,10 +77,13 @@ public:
 private:
     std::mt19937 rng{std::random_device{}()};
     std::map<Msg, Dig> tab;
+    std::mutex mtx;
 
 public:
     Dig hash(const Msg &msg)
     {
+        std::lock_guard lock{mtx};
+
         if (tab.contains(msg))
             return tab[msg];
 
@@ -54,6 +96,36 @@ public:
     }
 };
 
+// Stateless emulation of IdealCompression: outputs come from a seeded PRF instead of a lazily
+// sampled table, so memory is constant, queries are thread-safe and runs are reproducible
+template<size_t msg_sz, size_t dig_sz>
+class PrfCompression
+{
+    static_assert(msg_sz > dig_sz, "Not a compression function! (msg_sz <= dig_sz)");
+
+public:
+    static constexpr size_t MSG_SZ = msg_sz;
+    static constexpr size_t DIG_SZ = dig_sz;
+
+    using Msg = std::array<uint8_t, MSG_SZ>;
+    using Dig = std::array<uint8_t, DIG_SZ>;
+
+private:
+    Prf prf;
+
+public:
+    constexpr explicit PrfCompression(uint64_t seed) : prf{seed} {}
+
+    Dig hash(const Msg &msg) const
+    {
+        Dig dig;
+
+        prf.eval(dig, msg);
+
+        return dig;
+    }
+};
+
 template<auto &comp>
 class IdealCompressionProxy
 {
@@ -86,20 +158,54 @@ public:
     using Blk = std::array<uint8_t, BLK_SZ>;
     using Msg = std::vector<Blk>;
 
+    // Every query to the compression function goes through compress or compress_batch
+    static inline OracleStats stats{"MerkleDamgard::compress"};
+
     MerkleDamgard() = delete;
 
+    static Dig compress(const Dig &dig, const Blk &blk)
+    {
+        OracleStats::Probe probe{stats};
+        CMsg cmsg{};
+
+        std::ranges::copy(dig, cmsg.begin());
+        std::ranges::copy(blk, cmsg.begin() + dig.size());
+
+        return Comp::hash(cmsg);
+    }
+
+    // Compress many blocks under the same chaining value, in parallel if the compression
+    // function supports it
+    static void compress_batch(const Dig &dig, std::span<const Blk> blks, std::span<Dig> digs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<CMsg> cmsgs(blks.size());
+
+        for (size_t i = 0; i < blks.size(); ++i)
+        {
+            std::ranges::copy(dig, cmsgs[i].begin());
+            std::ranges::copy(blks[i], cmsgs[i].begin() + dig.size());
+        }
+
+        if constexpr (requires { Comp::hash_batch(std::span<const CMsg>{cmsgs}, digs); })
+            Comp::hash_batch(cmsgs, digs);
+        else
+            for (size_t i = 0; i < cmsgs.size(); ++i)
+                digs[i] = Comp::hash(cmsgs[i]);
+
+        auto dt = std::chrono::steady_clock::now() - start;
+
+        if (!blks.empty())
+            stats.record(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count(),
+                         blks.size());
+    }
+
     static Dig hash(const Msg &msg)
     {
         Dig dig{IV};
 
         for (size_t i = 0; i < msg.size(); ++i)
-        {
-            CMsg cmsg{};
-
-            std::ranges::copy(dig, cmsg.begin());
-            std::ranges::copy(msg[i], cmsg.begin() + dig.size());
-            dig = Comp::hash(cmsg);
-        }
+            dig = compress(dig, msg[i]);
 
         return dig;
     }
@@ -132,138 +238,617 @@ public:
 template<typename T>
 using Chain = std::vector<std::pair<T, T>>;
 
+// Little-endian encoding of q, zero-padded past its 8 bytes
+template<typename Blk>
+Blk blk_from_counter(size_t q)
+{
+    Blk blk{};
+
+    for (size_t i = 0; i < std::min(blk.size(), sizeof(q)); ++i)
+        blk[i] = (q >> (8 * i)) & 0xFF;
+
+    return blk;
+}
+
 template<typename Hash>
 std::pair<typename Hash::Blk, typename Hash::Blk> find_iv_comp_coll(const typename Hash::Dig &iv)
 {
     using Blk = typename Hash::Blk;
     using Dig = typename Hash::Dig;
-    using CMsg = typename Hash::CMsg;
-    using Comp = typename Hash::Comp;
 
     std::map<Dig, Blk> queries;
-    CMsg msg{};
+    std::vector<Blk> blks(COLL_BATCH);
+    std::vector<Dig> digs(COLL_BATCH);
 
-    std::ranges::copy(iv, msg.begin());
+    for (size_t q0 = 0;; q0 += COLL_BATCH)
+    {
+        for (size_t k = 0; k < COLL_BATCH; ++k)
+            blks[k] = blk_from_counter<Blk>(q0 + k);
 
-    for (size_t q = 0;; ++q)
+        Hash::compress_batch(iv, blks, digs);
+
+        for (size_t k = 0; k < COLL_BATCH; ++k)
+        {
+            auto [it, fresh] = queries.try_emplace(digs[k], blks[k]);
+
+            if (!fresh)
+                return {it->second, blks[k]};
+        }
+    }
+}
+
+// A digest together with the counter of the block that produced it
+template<typename Dig>
+struct DigRec
+{
+    Dig dig;
+    uint64_t q;
+};
+
+// LSD radix sort of the records by digest (byte 0 most significant, as std::array compares)
+template<typename Dig>
+void radix_sort(std::vector<DigRec<Dig>> &recs, std::vector<DigRec<Dig>> &tmp)
+{
+    tmp.resize(recs.size());
+
+    for (size_t b = std::tuple_size_v<Dig>; b-- > 0;)
     {
-        Blk blk;
+        std::array<size_t, 257> cnt{};
 
-        std::ranges::generate(blk, [&, i = 0] mutable { return (q >> (8 * i++)) & 0xFF; });
-        std::ranges::copy(blk, msg.begin() + iv.size());
+        for (auto &&r : recs)
+            ++cnt[r.dig[b] + 1];
+        for (size_t i = 1; i < cnt.size(); ++i)
+            cnt[i] += cnt[i - 1];
+        for (auto &&r : recs)
+            tmp[cnt[r.dig[b]]++] = r;
 
-        Dig dig{Comp::hash(msg)};
+        recs.swap(tmp);
+    }
+}
 
-        if (queries.contains(dig))
+// A run lost to a failed write or read would silently hide collisions, so give up loudly
+[[noreturn]] static void run_file_error(const std::filesystem::path &path, std::string_view op)
+{
+    std::println(stderr, "{}: {} failed!", path.string(), op);
+    std::exit(EXIT_FAILURE);
+}
+
+// Buffered sequential reader over a sorted run on disk
+template<typename Rec>
+class RunReader
+{
+    std::filesystem::path path;
+    std::ifstream fs;
+    std::vector<Rec> buf;
+    size_t pos = 0;
+
+    void refill()
+    {
+        buf.resize(EXT_READ_SZ);
+        fs.read(reinterpret_cast<char *>(buf.data()), buf.size() * sizeof(Rec));
+        buf.resize(fs.gcount() / sizeof(Rec));
+        pos = 0;
+
+        // Only a short read at the end of the file, on a record boundary, is fine
+        if (fs.bad() || (!fs && !fs.eof()) || fs.gcount() % sizeof(Rec))
+            run_file_error(path, "read");
+    }
+
+public:
+    explicit RunReader(const std::filesystem::path &path) : path{path}, fs{path, std::ios::binary}
+    {
+        if (!fs)
+            run_file_error(path, "open");
+        refill();
+    }
+
+    bool empty() const { return pos == buf.size(); }
+
+    const Rec &peek() const { return buf[pos]; }
+
+    void pop()
+    {
+        if (++pos == buf.size())
+            refill();
+    }
+};
+
+// Birthday search for digests too many to keep in memory: the queries are generated in runs of
+// run_sz records, each radix sorted and streamed to a temporary file, and the runs are then
+// k-way merged looking for equal adjacent digests. If the merge finds nothing, the number of
+// queries is doubled and the search resumes, reusing the runs already on disk.
+template<typename Hash>
+std::pair<typename Hash::Blk, typename Hash::Blk>
+find_iv_comp_coll_ext(const typename Hash::Dig &iv,
+                      const std::filesystem::path &dir = std::filesystem::temp_directory_path(),
+                      size_t run_sz = EXT_RUN_SZ)
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
+    using Rec = DigRec<Dig>;
+
+    static_assert(std::is_trivially_copyable_v<Rec>);
+
+    const std::filesystem::path run_dir = dir / std::format("birthday_{:x}", std::random_device{}());
+    std::vector<std::filesystem::path> runs;
+    std::vector<Rec> recs, tmp;
+    std::vector<Blk> blks(COLL_BATCH);
+    std::vector<Dig> digs(COLL_BATCH);
+    std::optional<std::pair<uint64_t, uint64_t>> coll;
+
+    // Two counters collide for real only if they produce different blocks
+    auto is_coll = [](uint64_t q0, uint64_t q1)
+    { return blk_from_counter<Blk>(q0) != blk_from_counter<Blk>(q1); };
+
+    std::filesystem::create_directories(run_dir);
+
+    size_t q = 0;
+    for (size_t target = 1ULL << (Hash::DIG_SZ * CHAR_BIT / 2 + 1); !coll; target *= 2)
+    {
+        // Generate, sort and spill the missing runs
+        while (q < target && !coll)
         {
-            total_queries += q;
+            size_t n = std::min(run_sz, target - q);
+
+            recs.clear();
+            for (size_t k0 = 0; k0 < n; k0 += COLL_BATCH)
+            {
+                size_t m = std::min(COLL_BATCH, n - k0);
+
+                for (size_t k = 0; k < m; ++k)
+                    blks[k] = blk_from_counter<Blk>(q + k0 + k);
+
+                Hash::compress_batch(iv, std::span{blks}.first(m), std::span{digs}.first(m));
 
-            return {queries[dig], blk};
+                for (size_t k = 0; k < m; ++k)
+                    recs.emplace_back(digs[k], q + k0 + k);
+            }
+            q += n;
+
+            radix_sort(recs, tmp);
+
+            for (size_t i = 1; i < recs.size() && !coll; ++i)
+                if (recs[i - 1].dig == recs[i].dig && is_coll(recs[i - 1].q, recs[i].q))
+                    coll = {recs[i - 1].q, recs[i].q};
+
+            runs.emplace_back(run_dir / std::format("run{}.bin", runs.size()));
+
+            std::ofstream fs{runs.back(), std::ios::binary};
+
+            fs.write(reinterpret_cast<const char *>(recs.data()), recs.size() * sizeof(Rec));
+            fs.close();
+            if (!fs)
+                run_file_error(runs.back(), "write");
         }
 
-        queries.emplace(dig, blk);
+        if (coll || runs.size() < 2)
+            continue;
+
+        // k-way merge of the sorted runs
+        std::vector<RunReader<Rec>> readers;
+        auto cmp = [&](size_t i, size_t j) { return readers[j].peek().dig < readers[i].peek().dig; };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(cmp)> heap{cmp};
+        std::optional<Rec> prev;
+
+        readers.reserve(runs.size());
+        for (auto &&run : runs)
+            readers.emplace_back(run);
+        for (size_t i = 0; i < readers.size(); ++i)
+            if (!readers[i].empty())
+                heap.push(i);
+
+        while (!heap.empty() && !coll)
+        {
+            size_t i = heap.top();
+            Rec r = readers[i].peek();
+
+            heap.pop();
+            readers[i].pop();
+            if (!readers[i].empty())
+                heap.push(i);
+
+            if (prev && prev->dig == r.dig && is_coll(prev->q, r.q))
+                coll = {prev->q, r.q};
+
+            prev = r;
+        }
     }
+
+    std::filesystem::remove_all(run_dir);
+
+    // Recompute the colliding inputs from their counters
+    Blk blk0 = blk_from_counter<Blk>(coll->first);
+    Blk blk1 = blk_from_counter<Blk>(coll->second);
+
+    if (Hash::compress(iv, blk0) != Hash::compress(iv, blk1))
+        std::println(stderr, "External birthday search returned a false collision!");
+
+    return {blk0, blk1};
 }
 
 template<typename Hash>
 Chain<typename Hash::Blk> find_hash_multicoll(size_t t = 1)
 {
-    using Comp = typename Hash::Comp;
     using Dig = typename Hash::Dig;
     using Blk = typename Hash::Blk;
-    using CMsg = typename Hash::CMsg;
 
     Chain<Blk> chain;
 
     Dig dig{Hash::IV};
     for (size_t i = 0; i < t; ++i)
     {
-        chain.emplace_back(find_iv_comp_coll<Hash>(dig));
-
-        CMsg msg{};
-        const Blk &blk = chain.back().first;
-
-        std::ranges::copy(dig, msg.begin());
-        std::ranges::copy(blk, msg.begin() + dig.size());
-        dig = Comp::hash(msg);
+        if constexpr (Hash::DIG_SZ * CHAR_BIT >= EXT_COLL_BITS)
+            chain.emplace_back(find_iv_comp_coll_ext<Hash>(dig));
+        else
+            chain.emplace_back(find_iv_comp_coll<Hash>(dig));
+        dig = Hash::compress(dig, chain.back().first);
     }
 
     return chain;
 }
 
+// Visit the digests of all the 2^t paths through the multicollision chain, stopping as soon as
+// `f(path, dig)` returns true. Bit j of `path` selects `chain[j].second` over `chain[j].first`.
+// Paths are walked in Gray-code order, with the fastest changing bit mapped to the last block,
+// so that only the changed suffix is recompressed: about 2^(t+1) compressions instead of t*2^t.
+template<typename Hash, typename F>
+void for_each_path_digest(const Chain<typename Hash::Blk> &chain, F &&f)
+{
+    using Dig = typename Hash::Dig;
+
+    size_t t = chain.size();
+    size_t path = 0;
+    std::vector<Dig> digs(t + 1, Hash::IV);
+
+    for (size_t j = 0; j < t; ++j)
+        digs[j + 1] = Hash::compress(digs[j], chain[j].first);
+
+    if (f(path, digs[t]))
+        return;
+
+    for (size_t k = 1, n = 1ULL << t; k < n; ++k)
+    {
+        size_t lvl = t - 1 - std::countr_zero(k);
+
+        path ^= 1ULL << lvl;
+        for (size_t j = lvl; j < t; ++j)
+            digs[j + 1] = Hash::compress(digs[j], path >> j & 1 ? chain[j].second : chain[j].first);
+
+        if (f(path, digs[t]))
+            return;
+    }
+}
+
 template<typename Hash>
 std::pair<size_t, size_t> find_coll_path(const Chain<typename Hash::Blk> &chain)
 {
     using Dig = typename Hash::Dig;
-    using Msg = typename Hash::Msg;
 
     std::map<Dig, size_t> queries;
+    std::pair<size_t, size_t> coll{};
+
+    for_each_path_digest<Hash>(chain, [&](size_t i, const Dig &dig)
+                               {
+                                   auto [it, fresh] = queries.try_emplace(dig, i);
+
+                                   if (!fresh)
+                                       coll = {it->second, i};
+
+                                   return !fresh;
+                               });
+
+    return coll;
+}
+
+template<typename Hash>
+std::vector<size_t> find_coll_paths(const Chain<typename Hash::Blk> &chain)
+{
+    using Dig = typename Hash::Dig;
+
+    std::map<Dig, std::vector<size_t>> queries;
+    std::vector<size_t> *found = nullptr;
+
+    for_each_path_digest<Hash>(chain, [&](size_t i, const Dig &dig)
+                               {
+                                   std::vector<size_t> &paths = queries[dig];
+
+                                   paths.emplace_back(i);
+                                   if (paths.size() == H2_PATH_N)
+                                       found = &paths;
+
+                                   return found != nullptr;
+                               });
+
+    if (found)
+        return *found;
+
+    std::println("Could not find enough collision, returing best candidate set...");
+
+    return std::ranges::max_element(queries, [](auto &&x, auto &&y)
+                                    { return x.second.size() < y.second.size(); })
+        ->second;
+}
+
+// Find blocks (b0, b1) with f(iv0, b0) = f(iv1, b1), growing the two query sets in turn
+template<typename Hash>
+std::pair<typename Hash::Blk, typename Hash::Blk> find_pair_comp_coll(const typename Hash::Dig &iv0,
+                                                                      const typename Hash::Dig &iv1)
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
 
-    for (size_t i = 0; i < 1ULL << chain.size(); ++i)
+    std::array<std::map<Dig, Blk>, 2> queries;
+    std::array<const Dig *, 2> ivs{&iv0, &iv1};
+
+    for (size_t q = 0;; ++q)
     {
-        Msg msg(chain.size());
+        size_t side = q & 1;
+        Blk blk = blk_from_counter<Blk>(q >> 1);
+        Dig dig = Hash::compress(*ivs[side], blk);
 
-        std::ranges::generate(msg, [&, j = 0] mutable
-                              { return i >> j & 1 ? chain[j++].second : chain[j++].first; });
+        if (auto it = queries[side ^ 1].find(dig); it != queries[side ^ 1].end())
+            return side ? std::pair{it->second, blk} : std::pair{blk, it->second};
+
+        queries[side].try_emplace(dig, blk);
+    }
+}
+
+// Diamond structure for the herding attack: a binary tree of chaining values whose 2^k leaves
+// all lead, through one block per level, to the same root
+template<typename Hash>
+struct Diamond
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
+    using Msg = typename Hash::Msg;
+
+    // nodes[j][i] is the i-th chaining value at level j, leaves are level 0
+    std::vector<std::vector<Dig>> nodes;
+    // blks[j][i] leads from nodes[j][i] to nodes[j + 1][i / 2]
+    std::vector<std::vector<Blk>> blks;
+
+    const Dig &root() const { return nodes.back().front(); }
+
+    Msg suffix(size_t leaf) const
+    {
+        Msg msg;
+
+        for (size_t j = 0; j < blks.size(); ++j, leaf /= 2)
+            msg.emplace_back(blks[j][leaf]);
 
-        Dig dig{Hash::hash(msg)};
+        return msg;
+    }
+};
+
+// Build the diamond level by level. The pairs of a level are independent, so each level is a
+// parallel loop over its pairs.
+template<typename Hash>
+Diamond<Hash> build_diamond(size_t k)
+{
+    using Dig = typename Hash::Dig;
+    using Blk = typename Hash::Blk;
+
+    Diamond<Hash> dmd;
+
+    dmd.nodes.emplace_back(1ULL << k);
+    for (size_t i = 0; i < dmd.nodes[0].size(); ++i)
+        dmd.nodes[0][i] = blk_from_counter<Dig>(i);
+
+    for (size_t j = 0; j < k; ++j)
+    {
+        const std::vector<Dig> &lvl = dmd.nodes[j];
+        std::vector<Dig> next(lvl.size() / 2);
+        std::vector<Blk> blks(lvl.size());
 
-        total_queries += chain.size();
-        if (queries.contains(dig))
-            return {queries[dig], i};
+#pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < next.size(); ++i)
+        {
+            auto [b0, b1] = find_pair_comp_coll<Hash>(lvl[2 * i], lvl[2 * i + 1]);
 
-        queries.emplace(dig, i);
+            blks[2 * i] = b0;
+            blks[2 * i + 1] = b1;
+            next[i] = Hash::compress(lvl[2 * i], b0);
+        }
+
+        dmd.blks.emplace_back(std::move(blks));
+        dmd.nodes.emplace_back(std::move(next));
     }
 
-    return {};
+    return dmd;
 }
 
+// Link an arbitrary prefix into the diamond: find a block taking H(prefix) to one of its leaves
+// and follow the diamond to the root
 template<typename Hash>
-std::vector<size_t> find_coll_paths(const Chain<typename Hash::Blk> &chain)
+typename Hash::Msg herd_prefix(const Diamond<Hash> &dmd, const typename Hash::Msg &prefix)
 {
+    using Blk = typename Hash::Blk;
     using Dig = typename Hash::Dig;
     using Msg = typename Hash::Msg;
 
-    std::map<Dig, std::vector<size_t>> queries;
+    std::map<Dig, size_t> leaves;
+    Dig dig{Hash::hash(prefix)};
+    std::vector<Blk> blks(COLL_BATCH);
+    std::vector<Dig> digs(COLL_BATCH);
+
+    for (size_t i = 0; i < dmd.nodes[0].size(); ++i)
+        leaves.try_emplace(dmd.nodes[0][i], i);
 
-    for (size_t i = 0, n = 1ULL << chain.size(); i < n; ++i)
+    for (size_t q0 = 0;; q0 += COLL_BATCH)
     {
-        Msg msg(chain.size());
+        for (size_t k = 0; k < COLL_BATCH; ++k)
+            blks[k] = blk_from_counter<Blk>(q0 + k);
 
-        std::ranges::generate(msg, [&, j = 0] mutable
-                              { return (i >> j) & 1 ? chain[j++].second : chain[j++].first; });
+        Hash::compress_batch(dig, blks, digs);
 
-        Dig dig{Hash::hash(msg)};
+        for (size_t k = 0; k < COLL_BATCH; ++k)
+            if (auto it = leaves.find(digs[k]); it != leaves.end())
+            {
+                Msg msg{prefix};
+                Msg sfx{dmd.suffix(it->second)};
 
-        total_queries += chain.size();
-        if (queries.contains(dig))
-            queries[dig].emplace_back(i);
-        else
-            queries[dig] = {i};
+                msg.emplace_back(blks[k]);
+                msg.insert(msg.end(), sfx.begin(), sfx.end());
 
-        if (queries[dig].size() == H2_PATH_N)
-            return queries[dig];
+                return msg;
+            }
     }
+}
 
-    std::println("Could not find enough collision, returing best candidate set...");
+// Expandable message (Kelsey-Schneier): piece i is a 1-block message colliding with a
+// (2^i + 1)-block one, so that k pieces can produce any length in [k, k + 2^k - 1] blocks, all
+// ending in the same chaining value
+template<typename Hash>
+struct ExpandableMessage
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
+    using Msg = typename Hash::Msg;
 
-    return std::ranges::max_element(queries, [](auto &&x, auto &&y)
-                                    { return x.second.size() < y.second.size(); })
-        ->second;
+    std::vector<std::pair<Blk, Msg>> pieces;
+    Dig dig{Hash::IV};
+
+    size_t min_len() const { return pieces.size(); }
+
+    size_t max_len() const { return pieces.size() + (1ULL << pieces.size()) - 1; }
+
+    Msg expand(size_t len) const
+    {
+        Msg msg;
+        size_t extra = len - min_len();
+
+        for (size_t i = 0; i < pieces.size(); ++i)
+            if (extra >> i & 1)
+                msg.insert(msg.end(), pieces[i].second.begin(), pieces[i].second.end());
+            else
+                msg.emplace_back(pieces[i].first);
+
+        return msg;
+    }
+};
+
+template<typename Hash>
+ExpandableMessage<Hash> build_expandable_msg(size_t k)
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
+    using Msg = typename Hash::Msg;
+
+    ExpandableMessage<Hash> em;
+    const Blk dummy{};
+
+    for (size_t i = 0; i < k; ++i)
+    {
+        Dig dig{em.dig};
+
+        for (size_t j = 0; j < 1ULL << i; ++j)
+            dig = Hash::compress(dig, dummy);
+
+        auto [b0, b1] = find_pair_comp_coll<Hash>(em.dig, dig);
+        Msg lng(1ULL << i, dummy);
+
+        lng.emplace_back(b1);
+        em.pieces.emplace_back(b0, std::move(lng));
+        em.dig = Hash::compress(em.dig, b0);
+    }
+
+    return em;
 }
 
-int main()
+// Digests are (pseudo)random, so their leading bytes make a good enough hash
+struct DigHash
 {
-    static IdealCompression<COMPRESS_IN, COMPRESS_OUT> comp1, comp2, comp3;
+    template<size_t sz>
+    size_t operator()(const std::array<uint8_t, sz> &dig) const
+    {
+        size_t h = 0;
+
+        std::memcpy(&h, dig.data(), std::min(sz, sizeof(h)));
 
-    using Hash1 = MerkleDamgard<IdealCompressionProxy<comp1>>;
-    using Hash2 = MerkleDamgard<IdealCompressionProxy<comp2>>;
-    using Hash3 = MerkleDamgard<IdealCompressionProxy<comp3>>;
+        return h;
+    }
+};
+
+// Long-message second preimage: index the intermediate chaining values of the target, bridge the
+// expandable message into one of them with a parallel search, then expand it to the right length.
+// Fails if the target is too short for the expandable message, or if no block bridges.
+template<typename Hash>
+std::optional<typename Hash::Msg> find_second_preimage(const typename Hash::Msg &target)
+{
+    using Blk = typename Hash::Blk;
+    using Dig = typename Hash::Dig;
+    using Msg = typename Hash::Msg;
+
+    size_t k = 1;
+    while (k + (1ULL << k) < target.size())
+        ++k;
+
+    ExpandableMessage<Hash> em{build_expandable_msg<Hash>(k)};
+
+    // tab[s_j] = j, with s_j the chaining value after j blocks; the prefix before the bridge
+    // block has j - 1 blocks and must be a length the expandable message can take
+    std::unordered_map<Dig, size_t, DigHash> tab;
+    Dig dig{Hash::IV};
+
+    for (size_t j = 1; j <= target.size(); ++j)
+    {
+        dig = Hash::compress(dig, target[j - 1]);
+
+        if (j - 1 >= em.min_len() && j - 1 <= em.max_len())
+            tab.try_emplace(dig, j);
+    }
+
+    if (tab.empty())
+        return std::nullopt;
+
+    // Every block is tried at most once
+    const size_t q_max =
+        Hash::BLK_SZ < sizeof(size_t) ? 1ULL << (CHAR_BIT * Hash::BLK_SZ) : SIZE_MAX;
+    std::atomic<bool> found{false};
+    size_t bridge_j = 0;
+    Blk bridge{};
+
+#pragma omp parallel
+    {
+        size_t th_id = omp_get_thread_num();
+        size_t th_n = omp_get_num_threads();
+
+        for (size_t q = th_id; q < q_max && !found.load(std::memory_order_relaxed); q += th_n)
+        {
+            Blk blk = blk_from_counter<Blk>(q);
+
+            if (auto it = tab.find(Hash::compress(em.dig, blk)); it != tab.end())
+            {
+#pragma omp critical
+                if (!found)
+                {
+                    bridge_j = it->second;
+                    bridge = blk;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    if (!found)
+        return std::nullopt;
+
+    Msg msg{em.expand(bridge_j - 1)};
+
+    msg.emplace_back(bridge);
+    msg.insert(msg.end(), target.begin() + bridge_j, target.end());
+
+    return msg;
+}
+
+template<typename Hash1, typename Hash2>
+int run_multicoll_attack()
+{
     using Hash = ChainHash<Hash1, Hash2>;
 
     std::println("Looking for 2^{} collisions in H1...", H1_CHAIN_N);
 
-    Chain<Hash1::Blk> chain{find_hash_multicoll<Hash1>(H1_CHAIN_N)};
+    Chain<typename Hash1::Blk> chain{find_hash_multicoll<Hash1>(H1_CHAIN_N)};
 
     if (std::ranges::any_of(chain, [&](auto &&x) { return x.first == x.second; }))
     {
@@ -271,8 +856,7 @@ int main()
         return 0;
     }
 
-    std::println("Found in {}/{} queries!", total_queries, H1_EXPQ);
-    total_queries = 0;
+    std::println("Found in {}/{} queries!", Hash1::stats.queries(), H1_EXPQ);
 
     std::println("Looking for a common collision with H2... ");
 
@@ -284,21 +868,21 @@ int main()
         std::println("Could not find a collision!");
         return 0;
     }
-    std::println("Found {} collisions in {}/{} queries!", paths.size(), total_queries, H2_EXPQ);
-    total_queries = 0;
+    std::println("Found {} collisions in {}/{} queries!", paths.size(), Hash2::stats.queries(),
+                 H2_EXPQ);
 
     bool still_same = true;
     bool all_diff = true;
 
-    Hash::Msg msg0(chain.size());
+    typename Hash::Msg msg0(chain.size());
     std::ranges::generate(msg0, [&, j = 0] mutable
                           { return paths[0] >> j & 1 ? chain[j++].second : chain[j++].first; });
 
-    Hash::Dig dig0{Hash::hash(msg0)};
+    typename Hash::Dig dig0{Hash::hash(msg0)};
 
     for (size_t i = 1; i < paths.size(); ++i)
     {
-        Hash::Msg msg(chain.size());
+        typename Hash::Msg msg(chain.size());
         std::ranges::generate(msg, [&, j = 0] mutable
                               { return paths[i] >> j & 1 ? chain[j++].second : chain[j++].first; });
 
@@ -339,3 +923,134 @@ int main()
 
     return 0;
 }
+
+template<typename Hash>
+int run_herding_attack()
+{
+    using Msg = typename Hash::Msg;
+
+    std::println("Building a diamond with 2^{} leaves...", HERD_K);
+
+    Diamond<Hash> dmd{build_diamond<Hash>(HERD_K)};
+
+    size_t build_q = Hash::stats.queries();
+
+    std::println("Built in {} queries, committing to {}", build_q, hexdump(dmd.root()));
+
+    Msg prefix(HERD_PREFIX_N);
+
+    for (auto &&blk : prefix)
+        randbytes(blk.data(), blk.size());
+
+    std::println("Herding prefix {}...", hexdump(prefix));
+
+    Msg msg{herd_prefix(dmd, prefix)};
+
+    std::println("Linked in {}/{} queries!", Hash::stats.queries() - build_q,
+                 1ULL << (OUT_BITS - HERD_K));
+    if (Hash::hash(msg) == dmd.root())
+        std::println("Herded to the committed digest!");
+    else
+        std::println("Herding failed!");
+
+    return 0;
+}
+
+template<typename Hash>
+int run_second_preimage_attack()
+{
+    using Msg = typename Hash::Msg;
+
+    Msg target(1ULL << SECPRE_LOG_LEN);
+
+    for (auto &&blk : target)
+        randbytes(blk.data(), blk.size());
+
+    std::println("Looking for a second preimage of a 2^{}-block message...", SECPRE_LOG_LEN);
+
+    std::optional<Msg> msg{find_second_preimage<Hash>(target)};
+
+    if (!msg)
+    {
+        std::println("No second preimage found in {} queries!", Hash::stats.queries());
+        return 0;
+    }
+
+    std::println("Found in {}/{} queries!", Hash::stats.queries(), SECPRE_EXPQ);
+
+    if (*msg == target)
+        std::println("Found the target itself!");
+    else if (msg->size() == target.size() && Hash::hash(*msg) == Hash::hash(target))
+        std::println("Different message, same length, same digest!");
+    else
+        std::println("Second preimage failed!");
+
+    return 0;
+}
+
+// Run the external-memory birthday search, whatever the digest width
+template<typename Hash>
+int run_ext_coll_attack()
+{
+    std::println("Looking for a collision with the external search, {} records per run...",
+                 EXT_FORCE_RUN_SZ);
+
+    auto [blk0, blk1] = find_iv_comp_coll_ext<Hash>(
+        Hash::IV, std::filesystem::temp_directory_path(), EXT_FORCE_RUN_SZ);
+
+    std::println("Found in {}/{} queries!", Hash::stats.queries(), 1ULL << (OUT_BITS / 2));
+    if (blk0 != blk1 && Hash::compress(Hash::IV, blk0) == Hash::compress(Hash::IV, blk1))
+        std::println("Collision between {} and {}!", hexdump(blk0), hexdump(blk1));
+    else
+        std::println("Collision failed!");
+
+    return 0;
+}
+
+template<typename Hash1, typename Hash2>
+int run_attack(std::string_view attack)
+{
+    Hash1::stats.rename("H1::compress");
+    Hash2::stats.rename("H2::compress");
+
+    if (attack == "joux")
+        return run_multicoll_attack<Hash1, Hash2>();
+    if (attack == "herd")
+        return run_herding_attack<Hash1>();
+    if (attack == "2ndpre")
+        return run_second_preimage_attack<Hash1>();
+    if (attack == "extcoll")
+        return run_ext_coll_attack<Hash1>();
+
+    std::println(stderr, "Unknown attack: {}", attack);
+
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+    static IdealCompression<COMPRESS_IN, COMPRESS_OUT> comp1, comp2;
+    static PrfCompression<COMPRESS_IN, COMPRESS_OUT> prf_comp1{PRF_SEED}, prf_comp2{PRF_SEED + 1};
+
+    std::string_view mode = argc > 1 ? argv[1] : "ideal";
+    std::string_view attack = argc > 2 ? argv[2] : "joux";
+
+    if (mode == "ideal")
+        return run_attack<MerkleDamgard<IdealCompressionProxy<comp1>>,
+                          MerkleDamgard<IdealCompressionProxy<comp2>>>(attack);
+    if (mode == "prf")
+        return run_attack<MerkleDamgard<IdealCompressionProxy<prf_comp1>>,
+                          MerkleDamgard<IdealCompressionProxy<prf_comp2>>>(attack);
+    if (mode == "aes")
+        return run_attack<MerkleDamgard<DaviesMeyer<Aes128Cipher, COMPRESS_IN, COMPRESS_OUT>>,
+                          MerkleDamgard<MatyasMeyerOseas<Aes128Cipher, COMPRESS_IN, COMPRESS_OUT>>>(
+            attack);
+    if (mode == "tc05")
+        return run_attack<MerkleDamgard<DaviesMeyer<Tc05Cipher, COMPRESS_IN, COMPRESS_OUT>>,
+                          MerkleDamgard<MatyasMeyerOseas<Tc05Cipher, COMPRESS_IN, COMPRESS_OUT>>>(
+            attack);
+
+    std::println(stderr, "Usage: {} [ideal|prf|aes|tc05] [joux|herd|2ndpre|extcoll]", argv[0]);
+
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+#include "intrinsics.h"
+#include "zp/zp.h"
+#include "zp/zp_poly.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Best of a few runs, in cycles
+static uint64_t time_mul(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int r = 0; r < 3; ++r)
+    {
+        uint64_t start = _rdtsc();
+        zp_poly_t z = zp_poly_mul(x, y, p);
+        uint64_t end = _rdtsc();
+
+        zp_poly_del(z);
+        if (end - start < best)
+            best = end - start;
+    }
+
+    return best;
+}
+
+// Threshold among cand[0..n) minimizing the time of a product of length len
+static size_t tune(const size_t *cand, size_t n, size_t len, size_t kara, uint64_t p)
+{
+    zp_poly_t x = zp_poly_new(len - 1);
+    zp_poly_t y = zp_poly_new(len - 1);
+    size_t best = cand[0];
+    uint64_t best_t = UINT64_MAX;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        x.c[i] = zp_rand(p);
+        y.c[i] = zp_rand(p);
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        // Tuning Karatsuba when kara is 0, with Toom-3 out of the way. NTTs are left out
+        if (kara)
+            zp_poly_mul_set_thresholds(kara, cand[i], SIZE_MAX);
+        else
+            zp_poly_mul_set_thresholds(cand[i], SIZE_MAX, SIZE_MAX);
+
+        uint64_t t = time_mul(x, y, p);
+
+        printf("  %zu: %" PRIu64 " cycles\n", cand[i], t);
+        if (t < best_t)
+        {
+            best_t = t;
+            best = cand[i];
+        }
+    }
+
+    zp_poly_del(x);
+    zp_poly_del(y);
+
+    return best;
+}
+
+// Shortest power-of-2 length from which NTTs beat the recursive products
+static size_t tune_ntt(size_t kara, size_t toom3, uint64_t p)
+{
+    for (size_t len = 64; len <= 65536; len *= 2)
+    {
+        zp_poly_t x = zp_poly_new(len - 1);
+        zp_poly_t y = zp_poly_new(len - 1);
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            x.c[i] = zp_rand(p);
+            y.c[i] = zp_rand(p);
+        }
+
+        zp_poly_mul_set_thresholds(kara, toom3, SIZE_MAX);
+        uint64_t t_rec = time_mul(x, y, p);
+        zp_poly_mul_set_thresholds(kara, toom3, 0);
+        uint64_t t_ntt = time_mul(x, y, p);
+
+        zp_poly_del(x);
+        zp_poly_del(y);
+
+        printf("  %zu: %" PRIu64 " vs %" PRIu64 " cycles\n", len, t_rec, t_ntt);
+        if (t_ntt < t_rec)
+            return len;
+    }
+
+    return SIZE_MAX;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Syntax: %s <p>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t p = strtoull(argv[1], NULL, 0);
+    static const size_t KARA[] = {8, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+    static const size_t TOOM3[] = {64, 96, 128, 192, 256, 384, 512, 768, 1024, SIZE_MAX};
+
+    printf("Karatsuba threshold, length 4096:\n");
+    size_t kara = tune(KARA, sizeof KARA / sizeof *KARA, 4096, 0, p);
+
+    printf("Toom-3 threshold, length 16384:\n");
+    size_t toom3 = tune(TOOM3, sizeof TOOM3 / sizeof *TOOM3, 16384, kara, p);
+
+    printf("NTT threshold, recursive vs NTT:\n");
+    size_t ntt = tune_ntt(kara, toom3, p);
+
+    printf("-DZP_POLY_KARATSUBA_THRESHOLD=%zu -DZP_POLY_TOOM3_THRESHOLD=%zu "
+           "-DZP_POLY_NTT_THRESHOLD=%zu\n",
+           kara, toom3, ntt);
+
+    return 0;
+}
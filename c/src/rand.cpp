@@ -4,18 +4,24 @@
 
 uint32_t prand32(uint32_t lo, uint32_t hi)
 {
+    using dist = std::uniform_int_distribution<uint32_t>;
+
     static std::mt19937 gen(std::random_device{}());
-    static std::uniform_int_distribution<uint32_t> dis{lo, hi};
+    static dist dis;
 
-    return dis(gen);
+    // The bounds change from call to call, only the generator state is kept
+    return dis(gen, dist::param_type{lo, hi});
 }
 
 uint64_t prand64(uint64_t lo, uint64_t hi)
 {
+    using dist = std::uniform_int_distribution<uint64_t>;
+
     static std::mt19937_64 gen(std::random_device{}());
-    static std::uniform_int_distribution<uint64_t> dis{lo, hi};
+    static dist dis;
 
-    return dis(gen);
+    // The bounds change from call to call, only the generator state is kept
+    return dis(gen, dist::param_type{lo, hi});
 }
 
 void randbytes(uint8_t *buf, size_t len)
@@ -0,0 +1,227 @@
+#include "rand.h"
+#include "utils.h"
+#include "zp/zp.h"
+#include "zp/zp_poly.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Moduli on both sides of 2^62: the NTT products work modulo p itself below it (if p is an NTT
+// prime) and through the three-prime CRT above it
+static const uint64_t PRIMES[] = {
+    2, 3, 998244353, 1000000007, (1ULL << 61) - 1, (1ULL << 62) + 135, 0xffffffffffffffc5,
+};
+
+// Karatsuba, Toom-3 and NTT thresholds, forcing each algorithm down to the smallest lengths
+static const size_t THRESHOLDS[][3] = {
+    {2, SIZE_MAX, SIZE_MAX},
+    {3, 9, SIZE_MAX},
+    {SIZE_MAX, SIZE_MAX, 1},
+    {ZP_POLY_KARATSUBA_THRESHOLD, ZP_POLY_TOOM3_THRESHOLD, ZP_POLY_NTT_THRESHOLD},
+};
+
+static zp_poly_t rand_poly(size_t deg, uint64_t p)
+{
+    zp_poly_t x = zp_poly_new(deg);
+
+    for (size_t i = 0; i <= deg; ++i)
+        x.c[i] = zp_new(prand64(0, p - 1));
+    if (zp_is_zero(x.c[deg]))
+        x.c[deg] = zp_one();
+
+    return x;
+}
+
+// Equal coefficients, the missing ones being zero
+static bool poly_eq(zp_poly_t x, zp_poly_t y)
+{
+    for (size_t i = 0; i < x.n || i < y.n; ++i)
+        if ((i < x.n ? x.c[i].v : 0) != (i < y.n ? y.c[i].v : 0))
+            return false;
+
+    return true;
+}
+
+static zp_poly_t mul_schoolbook(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    zp_poly_t z = zp_poly_new(x.n + y.n - 2);
+
+    for (size_t i = 0; i < x.n; ++i)
+        for (size_t j = 0; j < y.n; ++j)
+            z.c[i + j] = zp_add(z.c[i + j], zp_mul(x.c[i], y.c[j], p), p);
+
+    return z;
+}
+
+static zp_poly_t rem_schoolbook(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    size_t d_x = zp_poly_deg(x);
+    size_t d_y = zp_poly_deg(y);
+    zp_t lc_inv = zp_inv(y.c[d_y], p);
+
+    x = zp_poly_new_copy(x);
+    for (size_t i = d_x + 1; i-- > d_y;)
+    {
+        zp_t c = zp_mul(x.c[i], lc_inv, p);
+
+        for (size_t j = 0; j <= d_y; ++j)
+            x.c[i - j] = zp_sub(x.c[i - j], zp_mul(y.c[d_y - j], c, p), p);
+    }
+
+    return x;
+}
+
+static size_t test_mul(uint64_t p)
+{
+    size_t fails = 0;
+
+    for (size_t t = 0; t < sizeof THRESHOLDS / sizeof *THRESHOLDS; ++t)
+    {
+        zp_poly_mul_set_thresholds(THRESHOLDS[t][0], THRESHOLDS[t][1], THRESHOLDS[t][2]);
+
+        for (size_t k = 0; k < 20; ++k)
+        {
+            // Squarings, balanced and unbalanced products
+            size_t d_x = prand64(0, 300);
+            size_t d_y = k < 4 ? d_x : prand64(0, k < 12 ? 300 : 20);
+            zp_poly_t x = rand_poly(d_x, p);
+            zp_poly_t y = k < 2 ? zp_poly_new_copy(x) : rand_poly(d_y, p);
+            zp_poly_t z = zp_poly_mul(x, y, p);
+            zp_poly_t e = mul_schoolbook(x, y, p);
+
+            if (!poly_eq(z, e))
+            {
+                printf("  zp_poly_mul: p = %" PRIu64 ", degrees %zu x %zu, thresholds %zu\n", p,
+                       d_x, d_y, t);
+                ++fails;
+            }
+
+            zp_poly_del(x);
+            zp_poly_del(y);
+            zp_poly_del(z);
+            zp_poly_del(e);
+        }
+    }
+
+    zp_poly_mul_set_thresholds(ZP_POLY_KARATSUBA_THRESHOLD, ZP_POLY_TOOM3_THRESHOLD,
+                               ZP_POLY_NTT_THRESHOLD);
+
+    return fails;
+}
+
+static size_t test_rem(uint64_t p)
+{
+    size_t fails = 0;
+
+    // Moduli on both sides of ZP_POLY_REM_NEWTON_THRESHOLD
+    for (size_t k = 0; k < 30; ++k)
+    {
+        size_t d_y = prand64(1, 4 * ZP_POLY_REM_NEWTON_THRESHOLD);
+        size_t d_x = prand64(0, 4 * d_y);
+        zp_poly_t x = rand_poly(d_x, p);
+        zp_poly_t y = rand_poly(d_y, p);
+        zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(y, p);
+        zp_poly_t z = zp_poly_rem_ctx(x, &ctx);
+        zp_poly_t w = zp_poly_rem(x, y, p);
+        zp_poly_t e = rem_schoolbook(x, y, p);
+
+        if (!poly_eq(z, e) || !poly_eq(w, e))
+        {
+            printf("  zp_poly_rem_ctx: p = %" PRIu64 ", degrees %zu mod %zu\n", p, d_x, d_y);
+            ++fails;
+        }
+
+        zp_poly_rem_ctx_del(ctx);
+        zp_poly_del(x);
+        zp_poly_del(y);
+        zp_poly_del(z);
+        zp_poly_del(w);
+        zp_poly_del(e);
+    }
+
+    return fails;
+}
+
+static int mobius(size_t n)
+{
+    int mu = 1;
+
+    for (size_t q = 2; q * q <= n; ++q)
+        if (n % q == 0)
+        {
+            n /= q;
+            if (n % q == 0)
+                return 0;
+            mu = -mu;
+        }
+
+    return n > 1 ? -mu : mu;
+}
+
+// Monic irreducibles of degree d over GF(p), by Gauss's formula: sum mu(d / e) p^e over e | d, / d
+static uint64_t gauss_count(uint64_t p, size_t d)
+{
+    int64_t n = 0;
+
+    for (size_t e = 1; e <= d; ++e)
+        if (d % e == 0)
+            n += mobius(d / e) * (int64_t)pow64(p, e);
+
+    return n / d;
+}
+
+static size_t test_irred(uint64_t p, size_t max_deg)
+{
+    size_t fails = 0;
+
+    for (size_t d = 1; d <= max_deg; ++d)
+    {
+        uint64_t n = 0;
+        zp_poly_t x = zp_poly_new(d);
+
+        x.c[d] = zp_one();
+        for (uint64_t m = 0; m < pow64(p, d); ++m)
+        {
+            for (size_t i = 0, v = m; i < d; ++i, v /= p)
+                x.c[i] = zp_new(v % p);
+
+            n += zp_poly_is_irred(x, p);
+        }
+
+        zp_poly_del(x);
+
+        if (n != gauss_count(p, d))
+        {
+            printf("  zp_poly_is_irred: p = %" PRIu64 ", degree %zu, %" PRIu64 " found\n", p, d, n);
+            ++fails;
+        }
+    }
+
+    return fails;
+}
+
+int main(void)
+{
+    size_t fails = 0;
+
+    printf("zp_poly_mul against schoolbook...\n");
+    for (size_t i = 0; i < sizeof PRIMES / sizeof *PRIMES; ++i)
+        fails += test_mul(PRIMES[i]);
+
+    printf("zp_poly_rem_ctx against long division...\n");
+    for (size_t i = 0; i < sizeof PRIMES / sizeof *PRIMES; ++i)
+        fails += test_rem(PRIMES[i]);
+
+    printf("zp_poly_is_irred against Gauss's formula...\n");
+    fails += test_irred(2, 10);
+    fails += test_irred(3, 6);
+    fails += test_irred(5, 4);
+    fails += test_irred(7, 3);
+
+    printf(fails ? "%zu failures\n" : "All passed\n", fails);
+
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,6 +1,10 @@
 #include "zp/zp.h"
 #include "intrinsics.h"
+#include "zp/zp_ctx.h"
 #include "rand.h"
+#include "utils.h"
+
+#include <stdlib.h>
 
 zp_t zp_new(uint64_t x)
 {
@@ -62,28 +66,130 @@ zp_t zp_mul(zp_t x, zp_t y, uint64_t p)
 
 zp_t zp_pow(zp_t x, uint64_t y, uint64_t p)
 {
-    zp_t z = zp_one();
+    // Without a Montgomery form the native products of an even p gain nothing over the plain
+    // ladder, while the context still costs its divisions
+    if (!(p & 1))
+    {
+        zp_t z = zp_one();
+
+        while (y)
+        {
+            if (y & 1)
+                z = zp_mul(z, x, p);
+
+            x = zp_mul(x, x, p);
+            y >>= 1;
+        }
+
+        return z;
+    }
+
+    // The context costs a couple of divisions, the ladder then needs none
+    zp_ctx_t ctx = zp_ctx_new(p);
+
+    return zp_from_native(zp_native_pow(zp_to_native(x, &ctx), y, &ctx), &ctx);
+}
+
+zp_t zp_multi_pow(const zp_t *x, const uint64_t *y, size_t n, uint64_t p)
+{
+    zp_ctx_t ctx = zp_ctx_new(p);
+    uint64_t m = 0;
+
+    for (size_t k = 0; k < n; ++k)
+        m |= y[k];
 
-    while (y)
+    // Straus: fixed w-bit windows, the table of base k holds x[k]^1, ..., x[k]^(2^w - 1)
+    size_t w = pow_window(m);
+    size_t d = ((size_t)1 << w) - 1;
+    size_t bits = m ? 64 - __builtin_clzll(m) : 0;
+    zp_t *t = malloc(n * d * sizeof *t);
+    zp_t z = zp_native_one(&ctx);
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        t[k * d] = zp_to_native(x[k], &ctx);
+        for (size_t j = 1; j < d; ++j)
+            t[k * d + j] = zp_native_mul(t[k * d + j - 1], t[k * d], &ctx);
+    }
+
+    bool first = true; // squarings are skipped while z is still 1
+
+    for (size_t i = (bits + w - 1) / w; i--;)
     {
-        if (y & 1)
-            z = zp_mul(z, x, p);
+        for (size_t j = 0; j < w && !first; ++j)
+            z = zp_native_mul(z, z, &ctx);
+
+        for (size_t k = 0; k < n; ++k)
+        {
+            uint64_t e = y[k] >> (i * w) & d;
 
-        x = zp_mul(x, x, p);
-        y >>= 1;
+            if (e)
+                z = first ? t[k * d + e - 1] : zp_native_mul(z, t[k * d + e - 1], &ctx);
+            first &= !e;
+        }
     }
 
-    return z;
+    free(t);
+
+    return zp_from_native(z, &ctx);
 }
 
 zp_t zp_inv(zp_t x, uint64_t p)
 {
-    zp_t y = zp_pow(x, p - 2, p);
+    // Binary extended GCD keeping a * x = u and b * x = v mod p, with v odd. One bit of u goes
+    // per step, and the steps are branch-free so that random inputs cost no mispredictions.
+    // Halving mod p needs an odd p.
+    if (p & 1)
+    {
+        uint64_t u = x.v % p;
+        uint64_t v = p;
+        uint64_t a = 1;
+        uint64_t b = 0;
+        uint64_t h = (p >> 1) + 1; // 2^-1 mod p
+
+        while (u)
+        {
+            // If u is odd: swap so that u >= v, then u -= v
+            uint64_t odd = -(u & 1);
+            uint64_t swap = odd & -(uint64_t)(u < v);
+            uint64_t t = (u ^ v) & swap;
+
+            u ^= t;
+            v ^= t;
+            t = (a ^ b) & swap;
+            a ^= t;
+            b ^= t;
+
+            u -= v & odd;
+            t = b & odd;
+            a = a - t + (p & -(uint64_t)(a < t));
+
+            u >>= 1;
+            a = (a >> 1) + (h & -(a & 1));
+        }
+
+        return v == 1 ? zp_new(b) : zp_zero();
+    }
 
-    if (zp_mul(x, y, p).v == 1)
-        return y;
+    // Plain extended Euclid otherwise, keeping a * x = u and b * x = v mod p
+    uint64_t u = x.v % p;
+    uint64_t v = p;
+    zp_t a = zp_one();
+    zp_t b = zp_zero();
+
+    while (u)
+    {
+        uint64_t q = v / u;
+        uint64_t t = v - q * u;
+        zp_t c = zp_sub(b, zp_mul(zp_new(q % p), a, p), p);
+
+        v = u;
+        u = t;
+        b = a;
+        a = c;
+    }
 
-    return zp_zero();
+    return v == 1 ? b : zp_zero();
 }
 
 zp_t zp_div(zp_t x, zp_t y, uint64_t p)
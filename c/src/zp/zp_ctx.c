@@ -0,0 +1,149 @@
+#include "zp/zp_ctx.h"
+#include "utils.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+zp_ctx_t zp_ctx_new(uint64_t p)
+{
+    zp_ctx_t ctx = {.p = p};
+    uint64_t rem;
+
+    // Newton iteration for p^-1 mod 2^64: p is its own inverse mod 2^3, each step doubles the bits
+    if (p & 1)
+    {
+        uint64_t inv = p;
+
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - p * inv;
+
+        ctx.pinv = inv;
+    }
+
+    ctx.r1 = -p % p;
+
+    uint64_t hi, lo = _mulx64(ctx.r1, ctx.r1, &hi);
+
+    _divx64(hi, lo, p, &ctx.r2);
+
+    ctx.k = 64 - __builtin_clzll(p);
+    if (ctx.k <= ZP_CTX_BARRETT_BITS)
+        ctx.mu = ctx.k >= 32 ? _divx64(1ULL << (2 * ctx.k - 64), 0, p, &rem)
+                             : (1ULL << (2 * ctx.k)) / p;
+
+    return ctx;
+}
+
+zp_t zp_native_pow(zp_t x, uint64_t y, const zp_ctx_t *ctx)
+{
+    zp_t t[1 << (POW_WINDOW_MAX - 1)];
+    size_t w = pow_window(y);
+    size_t i = y ? 64 - __builtin_clzll(y) : 0;
+    zp_t z = zp_native_one(ctx);
+
+    // Odd powers x, x^3, ..., x^(2^w - 1)
+    t[0] = x;
+    if (w > 1)
+    {
+        zp_t x2 = zp_native_mul(x, x, ctx);
+
+        for (size_t k = 1; k < (size_t)1 << (w - 1); ++k)
+            t[k] = zp_native_mul(t[k - 1], x2, ctx);
+    }
+
+    // Bits [j, i) form a window when both ends are set: it costs i - j squarings and a product
+    for (bool first = true; i;)
+    {
+        if (!(y >> (i - 1) & 1))
+        {
+            z = zp_native_mul(z, z, ctx);
+            --i;
+            continue;
+        }
+
+        size_t j = i > w ? i - w : 0;
+
+        while (!(y >> j & 1))
+            ++j;
+
+        zp_t d = t[(y >> j & ((1ULL << (i - j)) - 1)) >> 1];
+
+        if (first)
+            z = d;
+        else
+        {
+            for (size_t k = j; k < i; ++k)
+                z = zp_native_mul(z, z, ctx);
+            z = zp_native_mul(z, d, ctx);
+        }
+
+        first = false;
+        i = j;
+    }
+
+    return z;
+}
+
+zp_t zp_mont_pow(zp_t x, uint64_t y, const zp_ctx_t *ctx)
+{
+    return zp_native_pow(x, y, ctx);
+}
+
+zp_t zp_mont_inv(zp_t x, const zp_ctx_t *ctx)
+{
+    zp_t y = zp_mont_pow(x, ctx->p - 2, ctx);
+
+    if (zp_mont_mul(x, y, ctx).v == ctx->r1)
+        return y;
+
+    return (zp_t){0};
+}
+
+zp_pow_table_t zp_pow_table_new(zp_t x, uint64_t p, size_t bits)
+{
+    zp_pow_table_t t = {.ctx = zp_ctx_new(p), .w = 4};
+    size_t d = ((size_t)1 << t.w) - 1;
+
+    t.n = bits ? (bits + t.w - 1) / t.w : 1;
+    t.c = malloc(t.n * d * sizeof *t.c);
+
+    // Row i + 1 starts from x^(2^(w * (i + 1))) = x^(d * 2^(w * i)) * x^(2^(w * i))
+    x = zp_to_native(x, &t.ctx);
+    for (size_t i = 0; i < t.n; ++i)
+    {
+        zp_t *row = t.c + i * d;
+
+        row[0] = i ? zp_native_mul(row[-1], row[-d], &t.ctx) : x;
+        for (size_t k = 1; k < d; ++k)
+            row[k] = zp_native_mul(row[k - 1], row[0], &t.ctx);
+    }
+
+    return t;
+}
+
+void zp_pow_table_del(zp_pow_table_t t)
+{
+    free(t.c);
+}
+
+zp_t zp_pow_table_pow(const zp_pow_table_t *t, uint64_t y)
+{
+    size_t d = ((size_t)1 << t->w) - 1;
+    zp_t z = zp_native_one(&t->ctx);
+
+    // No squarings at all: one product per non-zero digit of y
+    for (size_t i = 0; i < t->n && y; ++i, y >>= t->w)
+        if (y & d)
+            z = zp_native_mul(z, t->c[i * d + (y & d) - 1], &t->ctx);
+
+    // Digits past the table: finish with (x^(2^(w * n)))^y
+    if (y)
+    {
+        const zp_t *last = t->c + (t->n - 1) * d;
+        zp_t h = zp_native_mul(last[d - 1], last[0], &t->ctx);
+
+        z = zp_native_mul(z, zp_native_pow(h, y, &t->ctx), &t->ctx);
+    }
+
+    return zp_from_native(z, &t->ctx);
+}
@@ -1,5 +1,6 @@
 #include "zp/zp_mat.h"
 #include "zp/zp.h"
+#include "zp/zp_ctx.h"
 #include "zp/zp_vec.h"
 
 #include <stdlib.h>
@@ -120,24 +121,45 @@ zp_mat_t zp_mat_sub(zp_mat_t x, zp_mat_t y, uint64_t p)
 }
 
 zp_mat_t zp_mat_self_smul(zp_mat_t x, zp_t a, uint64_t p)
+{
+    // a may be unreduced, zp_prep_new needs it below p
+    return zp_mat_self_smul_prepared(x, zp_prep_new(zp_new(a.v % p), p), p);
+}
+
+zp_mat_t zp_mat_smul(zp_mat_t x, zp_t a, uint64_t p)
+{
+    return zp_mat_self_smul(zp_mat_new_copy(x), a, p);
+}
+
+zp_mat_t zp_mat_self_smul_prepared(zp_mat_t x, zp_prep_t a, uint64_t p)
 {
     for (size_t i = 0; i < x.rows; ++i)
         for (size_t j = 0; j < x.cols; ++j)
-            x.c[i * x.cols + j] = zp_mul(x.c[i * x.cols + j], a, p);
+            x.c[i * x.cols + j] = zp_prep_mul(x.c[i * x.cols + j], a, p);
 
     return x;
 }
 
-zp_mat_t zp_mat_smul(zp_mat_t x, zp_t a, uint64_t p)
+zp_mat_t zp_mat_smul_prepared(zp_mat_t x, zp_prep_t a, uint64_t p)
 {
-    return zp_mat_self_smul(zp_mat_new_copy(x), a, p);
+    return zp_mat_self_smul_prepared(zp_mat_new_copy(x), a, p);
 }
 
 zp_mat_t zp_mat_self_hmul(zp_mat_t x, zp_mat_t y, uint64_t p)
 {
+    zp_ctx_t ctx = zp_ctx_new(p);
+    zp_t r2 = zp_new(ctx.r2);
+
     for (size_t i = 0; i < x.rows; ++i)
         for (size_t j = 0; j < x.cols; ++j)
-            x.c[i * x.cols + j] = zp_mul(x.c[i * x.cols + j], y.c[i * x.cols + j], p);
+        {
+            zp_t z = x.c[i * x.cols + j];
+            zp_t w = y.c[i * x.cols + j];
+
+            // REDC(REDC(z * w) * 2^128) = z * w
+            x.c[i * x.cols + j] = p & 1 ? zp_mont_mul(zp_mont_mul(z, w, &ctx), r2, &ctx)
+                                        : zp_ctx_mul(z, w, &ctx);
+        }
 
     return x;
 }
@@ -171,9 +193,7 @@ zp_vec_t zp_mat_vmul(zp_mat_t x, zp_vec_t y, uint64_t p)
 
 zp_mat_t zp_mat_self_hinv(zp_mat_t x, uint64_t p)
 {
-    for (size_t i = 0; i < x.rows; ++i)
-        for (size_t j = 0; j < x.cols; ++j)
-            x.c[i * x.cols + j] = zp_inv(x.c[i * x.cols + j], p);
+    zp_vec_self_inv((zp_vec_t){.c = x.c, .n = x.rows * x.cols}, p);
 
     return x;
 }
@@ -195,9 +215,10 @@ zp_mat_t zp_mat_sdiv(zp_mat_t x, zp_t a, uint64_t p)
 
 zp_mat_t zp_mat_self_hdiv(zp_mat_t x, zp_mat_t y, uint64_t p)
 {
-    for (size_t i = 0; i < x.rows; ++i)
-        for (size_t j = 0; j < x.cols; ++j)
-            x.c[i * x.cols + j] = zp_mul(x.c[i * x.cols + j], zp_inv(y.c[i * x.cols + j], p), p);
+    zp_mat_t z = zp_mat_hinv(y, p);
+
+    zp_mat_self_hmul(x, z, p);
+    zp_mat_del(z);
 
     return x;
 }
@@ -0,0 +1,172 @@
+#include "zp/zp_ntt.h"
+#include "zp/zp.h"
+#include "zp/zp_ctx.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+// Root of unity of order 2^lg, 0 if none was found
+static zp_t zp_ntt_root(uint64_t p, size_t lg)
+{
+    if (!(p & 1) || p >> ZP_NTT_BITS || lg > (size_t)__builtin_ctzll(p - 1))
+        return zp_zero();
+
+    // c^((p - 1) / 2^lg) has order 2^lg exactly when c is a quadratic non-residue, which half
+    // of the candidates are
+    for (uint64_t c = 2; c < 64 && c < p; ++c)
+        if (zp_pow(zp_new(c), (p - 1) / 2, p).v == p - 1)
+            return zp_pow(zp_new(c), (p - 1) >> lg, p);
+
+    return zp_zero();
+}
+
+bool zp_ntt_is_supported(uint64_t p, size_t lg)
+{
+    return !zp_is_zero(zp_ntt_root(p, lg));
+}
+
+zp_ntt_t zp_ntt_new(uint64_t p, size_t lg)
+{
+    zp_t g = zp_ntt_root(p, lg);
+
+    if (zp_is_zero(g))
+    {
+        fprintf(stderr, "No root of unity of order 2^%zu modulo %" PRIu64 "!\n", lg, p);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t n = (size_t)1 << lg;
+    zp_ntt_t t = {.p = p,
+                  .lg = lg,
+                  .w = malloc(n * sizeof *t.w),
+                  .wi = malloc(n * sizeof *t.wi)};
+    zp_t gi = zp_inv(g, p);
+    zp_t a = zp_one();
+    zp_t b = zp_one();
+
+    // Top level by successive products, every other level is its even half
+    for (size_t j = 0; j < n / 2; ++j)
+    {
+        t.w[n / 2 + j] = zp_prep_new(a, p);
+        t.wi[n / 2 + j] = zp_prep_new(b, p);
+        a = zp_mul(a, g, p);
+        b = zp_mul(b, gi, p);
+    }
+
+    for (size_t m = n / 4; m; m >>= 1)
+        for (size_t j = 0; j < m; ++j)
+        {
+            t.w[m + j] = t.w[2 * m + 2 * j];
+            t.wi[m + j] = t.wi[2 * m + 2 * j];
+        }
+
+    return t;
+}
+
+void zp_ntt_del(zp_ntt_t t)
+{
+    free(t.w);
+    free(t.wi);
+}
+
+typedef struct zp_ntt_cache
+{
+    zp_ntt_t t;
+    struct zp_ntt_cache *next;
+} zp_ntt_cache_t;
+
+static zp_ntt_cache_t *ZP_NTT_CACHE;
+static mtx_t ZP_NTT_CACHE_MTX;
+static once_flag ZP_NTT_CACHE_ONCE = ONCE_FLAG_INIT;
+
+static void zp_ntt_cache_init()
+{
+    mtx_init(&ZP_NTT_CACHE_MTX, mtx_plain);
+}
+
+const zp_ntt_t *zp_ntt_get(uint64_t p, size_t lg)
+{
+    call_once(&ZP_NTT_CACHE_ONCE, zp_ntt_cache_init);
+    mtx_lock(&ZP_NTT_CACHE_MTX);
+
+    // Tables are never freed nor moved, so a pointer stays valid once handed out
+    zp_ntt_cache_t *e = ZP_NTT_CACHE;
+
+    while (e && (e->t.p != p || e->t.lg < lg))
+        e = e->next;
+
+    if (!e)
+    {
+        e = malloc(sizeof *e);
+        e->t = zp_ntt_new(p, lg);
+        e->next = ZP_NTT_CACHE;
+        ZP_NTT_CACHE = e;
+    }
+
+    mtx_unlock(&ZP_NTT_CACHE_MTX);
+
+    return &e->t;
+}
+
+// x * w mod p up to a multiple of p, in [0, 2p), for any x < 2^64 (Harvey)
+static inline uint64_t zp_ntt_mul_lazy(uint64_t x, zp_prep_t w, uint64_t p)
+{
+    uint64_t q = (uint64_t)(((uint128_t)x * w.q) >> 64);
+
+    return x * w.w.v - q * p;
+}
+
+// Gentleman-Sande butterflies, natural order in and bit-reversed order out
+void zp_ntt_forward(zp_vec_t x, const zp_ntt_t *t)
+{
+    uint64_t p = t->p;
+    uint64_t p2 = 2 * p;
+    uint64_t *a = (uint64_t *)x.c;
+
+    for (size_t m = x.n / 2; m; m >>= 1)
+        for (size_t i = 0; i < x.n; i += 2 * m)
+            for (size_t j = 0; j < m; ++j)
+            {
+                uint64_t u = a[i + j];
+                uint64_t v = a[i + j + m];
+                uint64_t s = u + v;
+
+                a[i + j] = s - (p2 & -(uint64_t)(s >= p2));
+                a[i + j + m] = zp_ntt_mul_lazy(u - v + p2, t->w[m + j], p);
+            }
+
+    for (size_t i = 0; i < x.n; ++i)
+        a[i] -= p & -(uint64_t)(a[i] >= p);
+}
+
+// Cooley-Tukey butterflies, bit-reversed order in and natural order out
+void zp_ntt_inverse(zp_vec_t x, const zp_ntt_t *t)
+{
+    uint64_t p = t->p;
+    uint64_t p2 = 2 * p;
+    uint64_t *a = (uint64_t *)x.c;
+
+    for (size_t m = 1; m < x.n; m <<= 1)
+        for (size_t i = 0; i < x.n; i += 2 * m)
+            for (size_t j = 0; j < m; ++j)
+            {
+                uint64_t u = a[i + j];
+                uint64_t v = zp_ntt_mul_lazy(a[i + j + m], t->wi[m + j], p);
+                uint64_t s = u + v;
+                uint64_t d = u - v + p2;
+
+                a[i + j] = s - (p2 & -(uint64_t)(s >= p2));
+                a[i + j + m] = d - (p2 & -(uint64_t)(d >= p2));
+            }
+
+    // 2^-lg = ((p + 1) / 2)^lg
+    zp_prep_t ninv = zp_prep_new(zp_pow(zp_new(p / 2 + 1), __builtin_ctzll(x.n), p), p);
+
+    for (size_t i = 0; i < x.n; ++i)
+    {
+        a[i] = zp_ntt_mul_lazy(a[i], ninv, p);
+        a[i] -= p & -(uint64_t)(a[i] >= p);
+    }
+}
@@ -1,6 +1,8 @@
 #include "zp/zp_poly.h"
 #include "utils.h"
 #include "zp/zp.h"
+#include "zp/zp_ctx.h"
+#include "zp/zp_ntt.h"
 #include "zp/zp_vec.h"
 
 #include <ctype.h>
@@ -150,39 +152,515 @@ zp_poly_t zp_poly_sub(zp_poly_t x, zp_poly_t y, uint64_t p)
     return zp_poly_self_sub(zp_poly_new_copy(x), y, p);
 }
 
-zp_poly_t zp_poly_self_mul(zp_poly_t x, zp_poly_t y, uint64_t p)
+static size_t zp_poly_karatsuba_threshold = ZP_POLY_KARATSUBA_THRESHOLD;
+static size_t zp_poly_toom3_threshold = ZP_POLY_TOOM3_THRESHOLD;
+static size_t zp_poly_ntt_threshold = ZP_POLY_NTT_THRESHOLD;
+
+void zp_poly_mul_set_thresholds(size_t karatsuba, size_t toom3, size_t ntt)
+{
+    zp_poly_karatsuba_threshold = max(karatsuba, 2);
+    zp_poly_toom3_threshold = max(toom3, 16); // the top of r3 must fit in the product
+    zp_poly_ntt_threshold = ntt;
+}
+
+// z = x * y for nx >= ny coefficients, z has nx + ny - 1. Each coefficient is a dot product
+// against y reversed (in s, ny long), so it is reduced only once
+static void zp_poly_mul_base(zp_t *z, const zp_t *x, size_t nx, const zp_t *y, size_t ny,
+                             zp_t *s, uint64_t p)
+{
+    for (size_t i = 0; i < ny; ++i)
+        s[i] = y[ny - 1 - i];
+
+    for (size_t k = 0; k < nx + ny - 1; ++k)
+    {
+        size_t lo = k >= ny ? k - ny + 1 : 0;
+        size_t n = min(k, nx - 1) - lo + 1;
+
+        z[k] = zp_vec_dot((zp_vec_t){.c = (zp_t *)x + lo, .n = n},
+                          (zp_vec_t){.c = s + ny - 1 - k + lo, .n = n}, p);
+    }
+}
+
+static bool zp_poly_mul_toom3_ok(size_t n, uint64_t p)
+{
+    // Interpolation divides by 2 and 3
+    return n >= zp_poly_toom3_threshold && p % 2 && p % 3;
+}
+
+// Scratch needed by zp_poly_mul_rec for n coefficients
+static size_t zp_poly_mul_rec_len(size_t n, uint64_t p)
+{
+    if (n <= zp_poly_karatsuba_threshold)
+        return n;
+
+    if (zp_poly_mul_toom3_ok(n, p))
+    {
+        size_t k = (n + 2) / 3;
+
+        return 8 * k + 5 * (2 * k - 1) + zp_poly_mul_rec_len(k, p);
+    }
+
+    size_t m = n - n / 2;
+
+    return 4 * m - 1 + zp_poly_mul_rec_len(m, p);
+}
+
+static void zp_poly_mul_rec(zp_t *z, const zp_t *x, const zp_t *y, size_t n, zp_t *s,
+                            const zp_ctx_t *ctx);
+
+// x = x0 + x1 t with t = x^h, then x * y = z0 + ((x0 + x1)(y0 + y1) - z0 - z2) t + z2 t^2
+static void zp_poly_mul_karatsuba(zp_t *z, const zp_t *x, const zp_t *y, size_t n, zp_t *s,
+                                  const zp_ctx_t *ctx)
+{
+    size_t h = n / 2;
+    size_t m = n - h;
+    zp_t *xs = s;
+    zp_t *ys = s + m;
+    zp_t *mid = s + 2 * m;
+
+    zp_poly_mul_rec(z, x, y, h, s, ctx);
+    zp_poly_mul_rec(z + 2 * h, x + h, y + h, m, s, ctx);
+    z[2 * h - 1] = zp_zero();
+
+    for (size_t i = 0; i < m; ++i)
+    {
+        xs[i] = i < h ? zp_ctx_add(x[i], x[h + i], ctx) : x[h + i];
+        ys[i] = i < h ? zp_ctx_add(y[i], y[h + i], ctx) : y[h + i];
+    }
+
+    zp_poly_mul_rec(mid, xs, ys, m, mid + 2 * m - 1, ctx);
+
+    // z0 and z2 overlap the middle of z, so they are subtracted before it changes
+    for (size_t i = 0; i < 2 * m - 1; ++i)
+        mid[i] = zp_ctx_sub(mid[i], z[2 * h + i], ctx);
+    for (size_t i = 0; i < 2 * h - 1; ++i)
+        mid[i] = zp_ctx_sub(mid[i], z[i], ctx);
+    for (size_t i = 0; i < 2 * m - 1; ++i)
+        z[h + i] = zp_ctx_add(z[h + i], mid[i], ctx);
+}
+
+// x = x0 + x1 t + x2 t^2 with t = x^k, evaluated at 0, 1, -1, -2 and infinity. The product is
+// interpolated from the five point products with Bodrato's sequence, which only divides by 2 and 3
+static void zp_poly_mul_toom3(zp_t *z, const zp_t *x, const zp_t *y, size_t n, zp_t *s,
+                              const zp_ctx_t *ctx)
+{
+    size_t k = (n + 2) / 3;
+    size_t l = n - 2 * k; // length of x2, at most k
+    size_t m = 2 * k - 1; // length of the point products
+    zp_t *e = s;          // x(1), y(1), x(-1), y(-1), x(-2), y(-2), x2, y2, k long each
+    zp_t *r = s + 8 * k;  // r(0), r(1), r(-1), r(-2), r(inf), m long each
+    zp_prep_t half = zp_prep_new(zp_new(ctx->p / 2 + 1), ctx->p);
+    zp_prep_t third = zp_prep_new(zp_inv(zp_new(3), ctx->p), ctx->p);
+
+    for (size_t j = 0; j < 2; ++j)
+    {
+        const zp_t *a = j ? y : x;
+        zp_t *a2 = e + (6 + j) * k;
+
+        for (size_t i = 0; i < k; ++i)
+        {
+            zp_t a0 = a[i];
+            zp_t a1 = a[k + i];
+
+            a2[i] = i < l ? a[2 * k + i] : zp_zero();
+
+            zp_t a02 = zp_ctx_add(a0, a2[i], ctx);
+            zp_t am1 = zp_ctx_sub(a02, a1, ctx);
+            zp_t am2 = zp_ctx_add(am1, a2[i], ctx);
+
+            // a(-2) = 2 (a(-1) + a2) - a0
+            e[j * k + i] = zp_ctx_add(a02, a1, ctx);
+            e[(2 + j) * k + i] = am1;
+            e[(4 + j) * k + i] = zp_ctx_sub(zp_ctx_add(am2, am2, ctx), a0, ctx);
+        }
+    }
+
+    zp_t *tmp = r + 5 * m;
+
+    zp_poly_mul_rec(r, x, y, k, tmp, ctx);
+    zp_poly_mul_rec(r + m, e, e + k, k, tmp, ctx);
+    zp_poly_mul_rec(r + 2 * m, e + 2 * k, e + 3 * k, k, tmp, ctx);
+    zp_poly_mul_rec(r + 3 * m, e + 4 * k, e + 5 * k, k, tmp, ctx);
+    zp_poly_mul_rec(r + 4 * m, e + 6 * k, e + 7 * k, k, tmp, ctx);
+
+    memset(z, 0, (2 * n - 1) * sizeof *z);
+
+    for (size_t i = 0; i < m; ++i)
+    {
+        zp_t r0 = r[i];
+        zp_t r4 = r[4 * m + i];
+        zp_t r3 = zp_prep_mul(zp_ctx_sub(r[3 * m + i], r[m + i], ctx), third, ctx->p);
+        zp_t r1 = zp_prep_mul(zp_ctx_sub(r[m + i], r[2 * m + i], ctx), half, ctx->p);
+        zp_t r2 = zp_ctx_sub(r[2 * m + i], r0, ctx);
+
+        r3 = zp_ctx_add(zp_prep_mul(zp_ctx_sub(r2, r3, ctx), half, ctx->p),
+                        zp_ctx_add(r4, r4, ctx), ctx);
+        r2 = zp_ctx_sub(zp_ctx_add(r2, r1, ctx), r4, ctx);
+        r1 = zp_ctx_sub(r1, r3, ctx);
+
+        // The padded top of r(inf) is zero, and z only has 2n - 1 coefficients
+        z[i] = zp_ctx_add(z[i], r0, ctx);
+        z[k + i] = zp_ctx_add(z[k + i], r1, ctx);
+        z[2 * k + i] = zp_ctx_add(z[2 * k + i], r2, ctx);
+        z[3 * k + i] = zp_ctx_add(z[3 * k + i], r3, ctx);
+        if (4 * k + i < 2 * n - 1)
+            z[4 * k + i] = zp_ctx_add(z[4 * k + i], r4, ctx);
+    }
+}
+
+// z = x * y for n coefficients each, z has 2n - 1
+static void zp_poly_mul_rec(zp_t *z, const zp_t *x, const zp_t *y, size_t n, zp_t *s,
+                            const zp_ctx_t *ctx)
+{
+    if (n <= zp_poly_karatsuba_threshold)
+        zp_poly_mul_base(z, x, n, y, n, s, ctx->p);
+    else if (zp_poly_mul_toom3_ok(n, ctx->p))
+        zp_poly_mul_toom3(z, x, y, n, s, ctx);
+    else
+        zp_poly_mul_karatsuba(z, x, y, n, s, ctx);
+}
+
+size_t zp_poly_mul_scratch_len(size_t d_x, size_t d_y, uint64_t p)
+{
+    size_t n = min(d_x, d_y) + 1;
+
+    // Chunk product and zero-padded last chunk
+    return 3 * n + zp_poly_mul_rec_len(n, p);
+}
+
+zp_poly_t zp_poly_self_mul_scratch(zp_poly_t x, zp_poly_t y, uint64_t p, zp_vec_t s)
 {
     size_t d_x = zp_poly_deg(x);
     size_t d_y = zp_poly_deg(y);
     zp_poly_t z = zp_poly_new(d_x + d_y);
+    const zp_t *a = d_x >= d_y ? x.c : y.c;
+    const zp_t *b = d_x >= d_y ? y.c : x.c;
+    size_t na = max(d_x, d_y) + 1;
+    size_t n = min(d_x, d_y) + 1;
+
+    if (n <= zp_poly_karatsuba_threshold)
+        zp_poly_mul_base(z.c, a, na, b, n, s.c, p);
+    else
+    {
+        // The longer factor is cut in chunks as long as the shorter one, so that the recursion
+        // only sees balanced products
+        zp_ctx_t ctx = zp_ctx_new(p);
+        zp_t *t = s.c;
+        zp_t *pad = s.c + 2 * n - 1;
 
-    for (size_t i = 0; i <= d_x; ++i)
-        for (size_t j = 0; j <= d_y; ++j)
-            z.c[i + j] = zp_add(z.c[i + j], zp_mul(x.c[i], y.c[j], p), p);
+        for (size_t i = 0; i < na; i += n)
+        {
+            const zp_t *c = a + i;
+            size_t len = min(n, na - i);
+
+            if (len < n)
+            {
+                memcpy(pad, c, len * sizeof *pad);
+                memset(pad + len, 0, (n - len) * sizeof *pad);
+                c = pad;
+            }
+
+            zp_poly_mul_rec(t, c, b, n, s.c + 3 * n, &ctx);
+
+            for (size_t j = 0; j < min(2 * n - 1, z.n - i); ++j)
+                z.c[i + j] = zp_ctx_add(z.c[i + j], t[j], &ctx);
+        }
+    }
+
+    zp_poly_move(&x, z);
+
+    return x;
+}
 
+// NTT primes for the CRT, c * 2^k + 1 with k >= 55. Their product exceeds n * 2^128 for any
+// transform length n we can allocate, so it bounds every coefficient of the integer product
+static const uint64_t ZP_POLY_NTT_PRIMES[] = {
+    4179340454199820289, // 29 * 2^57 + 1
+    2485986994308513793, // 69 * 2^55 + 1
+    2053641430080946177, // 57 * 2^55 + 1
+};
+
+// z = x * y mod q as a cyclic convolution of length 2^lg, s is as long. Coefficients of x and
+// y are reduced mod q on the way in, so p may exceed q
+static void zp_poly_mul_ntt_conv(zp_t *z, zp_poly_t x, zp_poly_t y, size_t d_x, size_t d_y,
+                                 size_t lg, uint64_t q, zp_t *s)
+{
+    const zp_ntt_t *t = zp_ntt_get(q, lg);
+    zp_prep_t one = zp_prep_new(zp_one(), q);
+    zp_ctx_t ctx = zp_ctx_new(q);
+    size_t n = (size_t)1 << lg;
+    bool sqr = x.c == y.c && d_x == d_y;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        z[i] = i <= d_x ? zp_prep_mul(x.c[i], one, q) : zp_zero();
+        s[i] = i <= d_y ? zp_prep_mul(y.c[i], one, q) : zp_zero();
+    }
+
+    zp_ntt_forward((zp_vec_t){.c = z, .n = n}, t);
+    // Squarings need a single forward transform
+    if (!sqr)
+        zp_ntt_forward((zp_vec_t){.c = s, .n = n}, t);
+
+    for (size_t i = 0; i < n; ++i)
+        z[i] = zp_ctx_mul(z[i], sqr ? z[i] : s[i], &ctx);
+
+    zp_ntt_inverse((zp_vec_t){.c = z, .n = n}, t);
+}
+
+zp_poly_t zp_poly_self_mul_ntt(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    size_t d_x = zp_poly_deg(x);
+    size_t d_y = zp_poly_deg(y);
+    zp_poly_t z = zp_poly_new_empty(d_x + d_y);
+    size_t lg = z.n > 1 ? 64 - __builtin_clzll(z.n - 1) : 0;
+    size_t n = (size_t)1 << lg;
+
+    // Directly modulo p when it is an NTT prime
+    if (zp_ntt_is_supported(p, lg))
+    {
+        zp_t *r = malloc(2 * n * sizeof *r);
+
+        zp_poly_mul_ntt_conv(r, x, y, d_x, d_y, lg, p, r + n);
+        memcpy(z.c, r, z.n * sizeof *z.c);
+        free(r);
+        zp_poly_move(&x, z);
+
+        return x;
+    }
+
+    // Otherwise the integer product is rebuilt from three primes with Garner's algorithm:
+    // z = a1 + a2 q1 + a3 q1 q2 with a_i < q_i, then reduced mod p
+    uint64_t q1 = ZP_POLY_NTT_PRIMES[0];
+    uint64_t q2 = ZP_POLY_NTT_PRIMES[1];
+    uint64_t q3 = ZP_POLY_NTT_PRIMES[2];
+    zp_t *r = malloc(4 * n * sizeof *r);
+
+    for (size_t i = 0; i < 3; ++i)
+        zp_poly_mul_ntt_conv(r + i * n, x, y, d_x, d_y, lg, ZP_POLY_NTT_PRIMES[i], r + 3 * n);
+
+    zp_prep_t q1inv2 = zp_prep_new(zp_inv(zp_new(q1 % q2), q2), q2);
+    zp_prep_t q1inv3 = zp_prep_new(zp_inv(zp_new(q1 % q3), q3), q3);
+    zp_prep_t q2inv3 = zp_prep_new(zp_inv(zp_new(q2 % q3), q3), q3);
+    zp_prep_t one = zp_prep_new(zp_new(1 % p), p);
+    zp_prep_t c1 = zp_prep_new(zp_new(q1 % p), p);
+    zp_prep_t c2 = zp_prep_new(zp_mul(zp_new(q1 % p), zp_new(q2 % p), p), p);
+
+    for (size_t i = 0; i < z.n; ++i)
+    {
+        uint64_t a1 = r[i].v;
+        zp_t a2 = zp_prep_mul(zp_new(r[n + i].v + q2 - a1 % q2), q1inv2, q2);
+        zp_t a3 = zp_prep_mul(zp_new(r[2 * n + i].v + q3 - a1 % q3), q1inv3, q3);
+
+        a3 = zp_prep_mul(zp_new(a3.v + q3 - a2.v % q3), q2inv3, q3);
+        z.c[i] = zp_add(zp_add(zp_prep_mul(zp_new(a1), one, p), zp_prep_mul(a2, c1, p), p),
+                        zp_prep_mul(a3, c2, p), p);
+    }
+
+    free(r);
     zp_poly_move(&x, z);
 
     return x;
 }
 
+zp_poly_t zp_poly_mul_ntt(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    return zp_poly_self_mul_ntt(zp_poly_new_copy(x), y, p);
+}
+
+zp_poly_t zp_poly_self_mul(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    size_t d_x = zp_poly_deg(x);
+    size_t d_y = zp_poly_deg(y);
+
+    if (min(d_x, d_y) + 1 >= zp_poly_ntt_threshold)
+        return zp_poly_self_mul_ntt(x, y, p);
+
+    zp_vec_t s = zp_vec_new_empty(zp_poly_mul_scratch_len(d_x, d_y, p));
+
+    x = zp_poly_self_mul_scratch(x, y, p, s);
+    zp_vec_del(s);
+
+    return x;
+}
+
 zp_poly_t zp_poly_mul(zp_poly_t x, zp_poly_t y, uint64_t p)
 {
     return zp_poly_self_mul(zp_poly_new_copy(x), y, p);
 }
 
+// x mod y by long division, with lc_inv the inverse of the leading coefficient of y
+static void zp_poly_rem_long(zp_poly_t x, size_t d_x, zp_poly_t y, size_t d_y, zp_prep_t lc_inv,
+                             uint64_t p)
+{
+    // Preparing c costs a division, which the row of d_y + 1 products pays back
+    for (size_t i = d_x + 1; i-- > d_y;)
+    {
+        zp_prep_t c = zp_prep_new(zp_prep_mul(x.c[i], lc_inv, p), p);
+
+        for (size_t j = 0; j <= d_y; ++j)
+            x.c[i - j] = zp_sub(x.c[i - j], zp_prep_mul(y.c[d_y - j], c, p), p);
+    }
+}
+
+// x * y mod t^n, for x and y of at most n coefficients
+static zp_poly_t zp_poly_mul_low(zp_t *x, size_t n_x, zp_t *y, size_t n_y, size_t n, uint64_t p)
+{
+    zp_poly_t z = zp_poly_mul((zp_poly_t){.c = x, .n = n_x}, (zp_poly_t){.c = y, .n = n_y}, p);
+
+    if (z.n > n)
+        z.n = n; // the tail is freed with the rest
+    else
+        zp_poly_resize(&z, n - 1);
+
+    return z;
+}
+
+zp_poly_rem_ctx_t zp_poly_rem_ctx_new(zp_poly_t r, uint64_t p)
+{
+    size_t d = zp_poly_deg(r);
+    zp_poly_rem_ctx_t ctx = {.r = zp_poly_new_empty(d),
+                             .lc_inv = zp_prep_new(zp_inv(r.c[d], p), p),
+                             .p = p};
+    zp_poly_t f = zp_poly_new_empty(d);
+
+    for (size_t i = 0; i <= d; ++i)
+    {
+        ctx.r.c[i] = r.c[i];
+        f.c[i] = r.c[d - i];
+    }
+
+    // Newton: g <- g (2 - f g) doubles the number of correct coefficients of 1 / f, starting
+    // from the inverse of f(0), the leading coefficient of r
+    zp_poly_t g = zp_poly_new_empty(0);
+
+    g.c[0] = ctx.lc_inv.w;
+
+    for (size_t n = 1; n < d;)
+    {
+        n = min(2 * n, d);
+
+        zp_poly_t e = zp_poly_mul_low(f.c, min(n, f.n), g.c, g.n, n, p);
+
+        zp_poly_self_neg(e, p);
+        e.c[0] = zp_add(e.c[0], zp_new(2 % p), p);
+        zp_poly_move(&g, zp_poly_mul_low(g.c, g.n, e.c, e.n, n, p));
+        zp_poly_del(e);
+    }
+
+    zp_poly_del(f);
+    ctx.inv = g;
+
+    return ctx;
+}
+
+void zp_poly_rem_ctx_del(zp_poly_rem_ctx_t ctx)
+{
+    zp_poly_del(ctx.r);
+    zp_poly_del(ctx.inv);
+}
+
+// c mod r for c of n <= 2d coefficients, written back to the first d of them and zeroing the
+// rest. The quotient has m = n - d coefficients and is the top of rev(c) / rev(r)
+static void zp_poly_rem_newton(zp_t *c, size_t n, const zp_poly_rem_ctx_t *ctx)
+{
+    size_t d = ctx->r.n - 1;
+    size_t m = n - d;
+    uint64_t p = ctx->p;
+    zp_t *rev = malloc(m * sizeof *rev);
+
+    for (size_t i = 0; i < m; ++i)
+        rev[i] = c[n - 1 - i];
+
+    zp_poly_t q = zp_poly_mul_low(rev, m, ctx->inv.c, min(m, ctx->inv.n), m, p);
+
+    for (size_t i = 0; i < m; ++i)
+        rev[i] = q.c[m - 1 - i];
+
+    // Only the low d coefficients of q r are needed, the others cancel with c
+    zp_poly_t t = zp_poly_mul_low(rev, m, ctx->r.c, ctx->r.n, d, p);
+
+    for (size_t i = 0; i < d; ++i)
+        c[i] = zp_sub(c[i], t.c[i], p);
+    for (size_t i = d; i < n; ++i)
+        c[i] = zp_zero();
+
+    zp_poly_del(t);
+    zp_poly_del(q);
+    free(rev);
+}
+
+zp_poly_t zp_poly_self_rem_ctx(zp_poly_t x, const zp_poly_rem_ctx_t *ctx)
+{
+    size_t d_x = zp_poly_deg(x);
+    size_t d = ctx->r.n - 1;
+
+    if (d < ZP_POLY_REM_NEWTON_THRESHOLD)
+    {
+        zp_poly_rem_long(x, d_x, ctx->r, d, ctx->lc_inv, ctx->p);
+
+        return x;
+    }
+
+    // The top 2d coefficients at a time: reducing them lowers the degree by d, and what is left
+    // below is untouched
+    while (d_x >= d)
+    {
+        size_t lo = d_x >= 2 * d ? d_x + 1 - 2 * d : 0;
+
+        zp_poly_rem_newton(x.c + lo, d_x + 1 - lo, ctx);
+        d_x = lo + d - 1;
+    }
+
+    return x;
+}
+
+zp_poly_t zp_poly_rem_ctx(zp_poly_t x, const zp_poly_rem_ctx_t *ctx)
+{
+    return zp_poly_self_rem_ctx(zp_poly_new_copy(x), ctx);
+}
+
+zp_poly_t zp_poly_self_pow_ctx(zp_poly_t x, uint64_t n, const zp_poly_rem_ctx_t *ctx)
+{
+    zp_poly_t z = zp_poly_self_rem_ctx(zp_poly_one(), ctx);
+
+    x = zp_poly_self_rem_ctx(x, ctx);
+
+    for (size_t i = n ? 64 - __builtin_clzll(n) : 0; i--;)
+    {
+        z = zp_poly_self_rem_ctx(zp_poly_self_mul(z, z, ctx->p), ctx);
+        if (n >> i & 1)
+            z = zp_poly_self_rem_ctx(zp_poly_self_mul(z, x, ctx->p), ctx);
+    }
+
+    zp_poly_move(&x, z);
+
+    return x;
+}
+
+zp_poly_t zp_poly_pow_ctx(zp_poly_t x, uint64_t n, const zp_poly_rem_ctx_t *ctx)
+{
+    return zp_poly_self_pow_ctx(zp_poly_new_copy(x), n, ctx);
+}
+
 zp_poly_t zp_poly_self_rem(zp_poly_t x, zp_poly_t y, uint64_t p)
 {
     size_t d_x = zp_poly_deg(x);
     size_t d_y = zp_poly_deg(y);
 
-    for (size_t i = d_x; i >= d_y; --i)
+    // The Newton inverse costs a few products, which long quotients pay back
+    if (d_y >= ZP_POLY_REM_NEWTON_THRESHOLD && d_x >= 2 * d_y)
     {
-        zp_t c = zp_div(x.c[i], y.c[d_y], p);
+        zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(y, p);
 
-        for (size_t j = 0; j <= d_y; ++j)
-            x.c[i - j] = zp_sub(x.c[i - j], zp_mul(y.c[d_y - j], c, p), p);
+        x = zp_poly_self_rem_ctx(x, &ctx);
+        zp_poly_rem_ctx_del(ctx);
+
+        return x;
     }
 
+    zp_poly_rem_long(x, d_x, y, d_y, zp_prep_new(zp_inv(y.c[d_y], p), p), p);
+
     return x;
 }
 
@@ -216,20 +694,262 @@ zp_t zp_poly_eval(zp_poly_t x, zp_t a, uint64_t p)
 {
     size_t d = zp_poly_maxdeg(x);
     zp_t r = x.c[d];
+    zp_prep_t w = zp_prep_new(zp_new(a.v % p), p); // a may be unreduced
 
     for (size_t i = 1; i <= d; ++i)
-        r = zp_add(zp_mul(r, a, p), x.c[d - i], p);
+        r = zp_add(zp_prep_mul(r, w, p), x.c[d - i], p);
 
     return r;
 }
 
+// Subproduct tree of n points: level 0 holds t - a_i, and node i of level l + 1 the product of
+// nodes 2i and 2i + 1 of level l, or a copy of node 2i when it is the last one. Node i of level l
+// thus vanishes on the points [i 2^l, (i + 1) 2^l). Levels are stored one after the other, and
+// the offset of level l is written to off[l]
+static zp_poly_t *zp_poly_tree_new(zp_vec_t a, uint64_t p, size_t *off, size_t *h)
+{
+    size_t total = 0;
+
+    *h = 0;
+    for (size_t len = a.n;; len = (len + 1) / 2)
+    {
+        off[(*h)++] = total;
+        total += len;
+        if (len == 1)
+            break;
+    }
+
+    zp_poly_t *t = malloc(total * sizeof *t);
+
+    for (size_t i = 0; i < a.n; ++i)
+    {
+        t[i] = zp_poly_new(1);
+        t[i].c[0] = zp_neg(a.c[i], p);
+        t[i].c[1] = zp_one();
+    }
+
+    for (size_t l = 1, len = a.n; l < *h; ++l)
+    {
+        zp_poly_t *lo = t + off[l - 1];
+        zp_poly_t *hi = t + off[l];
+
+        for (size_t i = 0; 2 * i < len; ++i)
+            hi[i] = 2 * i + 1 < len ? zp_poly_mul(lo[2 * i], lo[2 * i + 1], p)
+                                    : zp_poly_new_copy(lo[2 * i]);
+
+        len = (len + 1) / 2;
+    }
+
+    return t;
+}
+
+static void zp_poly_tree_del(zp_poly_t *t, const size_t *off, size_t h)
+{
+    for (size_t i = 0; i < off[h - 1] + 1; ++i)
+        zp_poly_del(t[i]);
+
+    free(t);
+}
+
+// x mod m through a reduction context, so that the quotient costs products and not a division
+// step per coefficient
+static zp_poly_t zp_poly_tree_rem(zp_poly_t x, zp_poly_t m, uint64_t p)
+{
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(m, p);
+    size_t d = zp_poly_deg(m);
+
+    x = zp_poly_rem_ctx(x, &ctx);
+    zp_poly_rem_ctx_del(ctx);
+    // Horner at the leaves runs over all the coefficients
+    zp_poly_resize(&x, d ? d - 1 : 0);
+
+    return x;
+}
+
+// Values of x, already reduced modulo node i of level l, at the points of that node
+static void zp_poly_eval_tree(zp_poly_t x, const zp_poly_t *t, const size_t *off, size_t l,
+                              size_t i, zp_vec_t a, zp_t *z, uint64_t p)
+{
+    size_t lo = i << l;
+    size_t n = min((size_t)1 << l, a.n - lo);
+
+    if (n <= ZP_POLY_EVAL_TREE_THRESHOLD)
+    {
+        for (size_t j = 0; j < n; ++j)
+            z[lo + j] = zp_poly_eval(x, a.c[lo + j], p);
+
+        return;
+    }
+
+    // Node i carried up from level l - 1 has a single child
+    const zp_poly_t *c = t + off[l - 1] + 2 * i;
+
+    if (n <= (size_t)1 << (l - 1))
+    {
+        zp_poly_eval_tree(x, t, off, l - 1, 2 * i, a, z, p);
+
+        return;
+    }
+
+    for (size_t k = 0; k < 2; ++k)
+    {
+        zp_poly_t y = zp_poly_tree_rem(x, c[k], p);
+
+        zp_poly_eval_tree(y, t, off, l - 1, 2 * i + k, a, z, p);
+        zp_poly_del(y);
+    }
+}
+
+// zp_poly_eval_many with the tree of a already built
+static void zp_poly_eval_many_tree(zp_poly_t x, const zp_poly_t *t, const size_t *off, size_t h,
+                                   zp_vec_t a, zp_t *z, uint64_t p)
+{
+    zp_poly_t y = zp_poly_tree_rem(x, t[off[h - 1]], p);
+
+    zp_poly_eval_tree(y, t, off, h - 1, 0, a, z, p);
+    zp_poly_del(y);
+}
+
+zp_vec_t zp_poly_eval_many(zp_poly_t x, zp_vec_t a, uint64_t p)
+{
+    zp_vec_t z = zp_vec_new_empty(a.n);
+
+    if (a.n <= ZP_POLY_EVAL_TREE_THRESHOLD)
+    {
+        for (size_t i = 0; i < a.n; ++i)
+            z.c[i] = zp_poly_eval(x, a.c[i], p);
+
+        return z;
+    }
+
+    size_t off[64];
+    size_t h;
+    zp_poly_t *t = zp_poly_tree_new(a, p, off, &h);
+
+    zp_poly_eval_many_tree(x, t, off, h, a, z.c, p);
+    zp_poly_tree_del(t, off, h);
+
+    return z;
+}
+
+// sum_j c_j m / (t - a_j) over the points of node i of level l, with m that node
+static zp_poly_t zp_poly_interp_tree(const zp_poly_t *t, const size_t *off, size_t l, size_t i,
+                                     size_t n, const zp_t *c, uint64_t p)
+{
+    if (l == 0)
+    {
+        zp_poly_t z = zp_poly_new_empty(0);
+
+        z.c[0] = c[i];
+
+        return z;
+    }
+
+    if ((2 * i + 1) << (l - 1) >= n)
+        return zp_poly_interp_tree(t, off, l - 1, 2 * i, n, c, p);
+
+    const zp_poly_t *m = t + off[l - 1] + 2 * i;
+    zp_poly_t z0 = zp_poly_interp_tree(t, off, l - 1, 2 * i, n, c, p);
+    zp_poly_t z1 = zp_poly_interp_tree(t, off, l - 1, 2 * i + 1, n, c, p);
+
+    z0 = zp_poly_self_mul(z0, m[1], p);
+    z1 = zp_poly_self_mul(z1, m[0], p);
+    z0 = zp_poly_self_add(z0, z1, p);
+    zp_poly_del(z1);
+
+    return z0;
+}
+
+zp_poly_t zp_poly_interp(zp_vec_t a, zp_vec_t y, uint64_t p)
+{
+    if (a.n == 0)
+        return zp_poly_zero();
+
+    // Lagrange: z = sum_i y_i / m'(a_i) m / (t - a_i), with m = prod_i (t - a_i)
+    size_t off[64];
+    size_t h;
+    zp_poly_t *t = zp_poly_tree_new(a, p, off, &h);
+    zp_poly_t m = t[off[h - 1]];
+    zp_poly_t dm = zp_poly_new_empty(a.n - 1);
+
+    for (size_t i = 1; i <= a.n; ++i)
+        dm.c[i - 1] = zp_mul(m.c[i], zp_new(i % p), p);
+
+    zp_vec_t c = zp_vec_new_empty(a.n);
+
+    zp_poly_eval_many_tree(dm, t, off, h, a, c.c, p);
+    zp_vec_self_inv(c, p);
+    for (size_t i = 0; i < a.n; ++i)
+        c.c[i] = zp_mul(c.c[i], y.c[i], p);
+
+    zp_poly_t z = zp_poly_interp_tree(t, off, h - 1, 0, a.n, c.c, p);
+
+    zp_vec_del(c);
+    zp_poly_del(dm);
+    zp_poly_tree_del(t, off, h);
+
+    return z;
+}
+
+zp_poly_t zp_poly_gcd(zp_poly_t x, zp_poly_t y, uint64_t p)
+{
+    zp_poly_t a = zp_poly_new_copy(x);
+    zp_poly_t b = zp_poly_new_copy(y);
+
+    while (!zp_poly_is_zero(b))
+    {
+        zp_poly_t t = zp_poly_self_rem(a, b, p);
+
+        a = b;
+        b = t;
+    }
+
+    zp_poly_del(b);
+
+    size_t d = zp_poly_deg(a);
+    zp_prep_t c = zp_prep_new(zp_inv(a.c[d], p), p);
+
+    zp_poly_resize(&a, d);
+    for (size_t i = 0; i <= d && !zp_is_zero(c.w); ++i)
+        a.c[i] = zp_prep_mul(a.c[i], c, p);
+
+    return a;
+}
+
 bool zp_poly_is_irred(zp_poly_t x, uint64_t p)
 {
-    for (size_t i = 0; i < p; ++i)
-        if (zp_poly_eval(x, zp_new(i), p).v == 0)
-            return false;
+    size_t d = zp_poly_deg(x);
 
-    return true;
+    if (d == 0)
+        return false;
+
+    // x of degree d is reducible iff it has an irreducible factor of degree i <= d / 2, and the
+    // product of all of them divides t^(p^i) - t. Powers are raised to p once per step
+    zp_poly_rem_ctx_t ctx = zp_poly_rem_ctx_new(x, p);
+    zp_poly_t t = zp_poly_new(1);
+    zp_poly_t u = zp_poly_new(1);
+    bool irred = true;
+
+    t.c[1] = zp_one();
+    u.c[1] = zp_one();
+
+    for (size_t i = 1; i <= d / 2 && irred; ++i)
+    {
+        u = zp_poly_self_pow_ctx(u, p, &ctx);
+
+        zp_poly_t v = zp_poly_sub(u, t, p);
+        zp_poly_t g = zp_poly_gcd(x, v, p);
+
+        irred = zp_poly_deg(g) == 0;
+        zp_poly_del(g);
+        zp_poly_del(v);
+    }
+
+    zp_poly_del(u);
+    zp_poly_del(t);
+    zp_poly_rem_ctx_del(ctx);
+
+    return irred;
 }
 
 zp_poly_t zp_poly_find_irred(uint64_t p, size_t k)
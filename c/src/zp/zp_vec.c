@@ -1,6 +1,8 @@
 #include "zp/zp_vec.h"
 #include "fq/fq.h"
 #include "zp/zp.h"
+#include "zp/zp_ctx.h"
+#include "utils.h"
 #include "zp/zp_poly.h"
 
 #include <ctype.h>
@@ -8,6 +10,165 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Vector kernels for small moduli: products are split at the lane width and the halves are
+// accumulated separately, so a dot product is only reduced once at the end. Hadamard products
+// use a Montgomery reduction matching the lane width, 2^52 with IFMA and 2^32 with plain AVX2.
+#if defined(__AVX512IFMA__) && defined(__AVX512VL__)
+    #define ZP_VEC_SIMD_BITS 52
+#elif defined(__AVX2__)
+    #define ZP_VEC_SIMD_BITS 32
+#endif
+
+static uint64_t zp_vec_reduce128(uint128_t x, uint64_t p)
+{
+    uint64_t r;
+
+    _divx64((uint64_t)(x >> 64) % p, (uint64_t)x, p, &r);
+
+    return r;
+}
+
+#if ZP_VEC_SIMD_BITS == 52
+// REDC(x * y) = x * y * 2^-52 mod p on 8 lanes, for x, y < p < 2^52 and p odd
+static inline __m512i zp_vec_mont_mul_simd(__m512i x, __m512i y, __m512i p, __m512i pinv)
+{
+    __m512i zero = _mm512_setzero_si512();
+    __m512i lo = _mm512_madd52lo_epu64(zero, x, y);
+    __m512i hi = _mm512_madd52hi_epu64(zero, x, y);
+    __m512i m = _mm512_madd52lo_epu64(zero, lo, pinv);
+    __m512i mp = _mm512_madd52hi_epu64(zero, m, p);
+    __m512i r = _mm512_sub_epi64(hi, mp);
+
+    // m * p = x * y mod 2^52, so the low halves cancel and hi - mp is in (-p, p)
+    return _mm512_mask_add_epi64(r, _mm512_cmplt_epu64_mask(hi, mp), r, p);
+}
+
+// Returns the number of elements processed, a multiple of the lane count
+static size_t zp_vec_hmul_simd(zp_t *x, const zp_t *y, size_t n, const zp_ctx_t *ctx)
+{
+    uint64_t r = (1ULL << 52) % ctx->p;
+    __m512i p = _mm512_set1_epi64(ctx->p);
+    __m512i pinv = _mm512_set1_epi64(ctx->pinv);
+    __m512i r2 = _mm512_set1_epi64(zp_mul(zp_new(r), zp_new(r), ctx->p).v);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i z = zp_vec_mont_mul_simd(_mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i), p,
+                                         pinv);
+
+        _mm512_storeu_si512(x + i, zp_vec_mont_mul_simd(z, r2, p, pinv));
+    }
+
+    return i;
+}
+
+static zp_t zp_vec_dot_simd(const zp_t *x, const zp_t *y, size_t n, uint64_t p)
+{
+    uint128_t lo = 0;
+    uint128_t hi = 0;
+    size_t i = 0;
+
+    // A lane takes 2^12 halves before overflowing, a sum of 8 lanes 2^9
+    while (i + 8 <= n)
+    {
+        size_t end = min(n - n % 8, i + 8 * 512);
+        __m512i acc_lo = _mm512_setzero_si512();
+        __m512i acc_hi = _mm512_setzero_si512();
+
+        for (; i < end; i += 8)
+        {
+            __m512i a = _mm512_loadu_si512(x + i);
+            __m512i b = _mm512_loadu_si512(y + i);
+
+            acc_lo = _mm512_madd52lo_epu64(acc_lo, a, b);
+            acc_hi = _mm512_madd52hi_epu64(acc_hi, a, b);
+        }
+
+        lo += (uint64_t)_mm512_reduce_add_epi64(acc_lo);
+        hi += (uint64_t)_mm512_reduce_add_epi64(acc_hi);
+    }
+
+    for (; i < n; ++i)
+        lo += (uint128_t)x[i].v * y[i].v;
+
+    hi = (uint128_t)zp_vec_reduce128(hi, p) << 52;
+
+    return zp_add(zp_new(zp_vec_reduce128(hi, p)), zp_new(zp_vec_reduce128(lo, p)), p);
+}
+#elif ZP_VEC_SIMD_BITS == 32
+// REDC(x * y) = x * y * 2^-32 mod p on 4 lanes, for x, y < p < 2^32 and p odd
+static inline __m256i zp_vec_mont_mul_simd(__m256i x, __m256i y, __m256i p, __m256i pinv)
+{
+    __m256i t = _mm256_mul_epu32(x, y);
+    __m256i m = _mm256_mul_epu32(t, pinv);
+    __m256i mp = _mm256_mul_epu32(m, p);
+    __m256i r = _mm256_sub_epi64(_mm256_srli_epi64(t, 32), _mm256_srli_epi64(mp, 32));
+
+    // m * p = x * y mod 2^32, so the low halves cancel and r is in (-p, p)
+    return _mm256_add_epi64(r, _mm256_and_si256(p, _mm256_cmpgt_epi64(_mm256_setzero_si256(), r)));
+}
+
+// Returns the number of elements processed, a multiple of the lane count
+static size_t zp_vec_hmul_simd(zp_t *x, const zp_t *y, size_t n, const zp_ctx_t *ctx)
+{
+    __m256i p = _mm256_set1_epi64x(ctx->p);
+    __m256i pinv = _mm256_set1_epi64x(ctx->pinv);
+    __m256i r2 = _mm256_set1_epi64x(ctx->r1); // (2^32)^2 mod p
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+        __m256i z = zp_vec_mont_mul_simd(zp_vec_mont_mul_simd(a, b, p, pinv), r2, p, pinv);
+
+        _mm256_storeu_si256((__m256i *)(x + i), z);
+    }
+
+    return i;
+}
+
+static zp_t zp_vec_dot_simd(const zp_t *x, const zp_t *y, size_t n, uint64_t p)
+{
+    __m256i mask = _mm256_set1_epi64x(UINT32_MAX);
+    uint128_t lo = 0;
+    uint128_t hi = 0;
+    size_t i = 0;
+
+    // A lane takes 2^32 halves before overflowing, a sum of 4 lanes 2^30
+    while (i + 4 <= n)
+    {
+        size_t end = min(n - n % 4, i + 4 * (1ULL << 30));
+        __m256i acc_lo = _mm256_setzero_si256();
+        __m256i acc_hi = _mm256_setzero_si256();
+        uint64_t t[4];
+
+        for (; i < end; i += 4)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+            __m256i z = _mm256_mul_epu32(a, b);
+
+            acc_lo = _mm256_add_epi64(acc_lo, _mm256_and_si256(z, mask));
+            acc_hi = _mm256_add_epi64(acc_hi, _mm256_srli_epi64(z, 32));
+        }
+
+        _mm256_storeu_si256((__m256i *)t, acc_lo);
+        lo += t[0] + t[1] + t[2] + t[3];
+        _mm256_storeu_si256((__m256i *)t, acc_hi);
+        hi += t[0] + t[1] + t[2] + t[3];
+    }
+
+    for (; i < n; ++i)
+        lo += (uint128_t)x[i].v * y[i].v;
+
+    hi = (uint128_t)zp_vec_reduce128(hi, p) << 32;
+
+    return zp_add(zp_new(zp_vec_reduce128(hi, p)), zp_new(zp_vec_reduce128(lo, p)), p);
+}
+#endif
+
 zp_vec_t zp_vec_new_empty(size_t n)
 {
     return (zp_vec_t){.c = malloc(n * sizeof(zp_t)), .n = n};
@@ -63,8 +224,21 @@ void zp_vec_move(zp_vec_t *x, zp_vec_t y)
 
 zp_vec_t zp_vec_self_add(zp_vec_t x, zp_vec_t y, uint64_t p)
 {
+    if (p >> 63)
+    {
+        for (size_t i = 0; i < x.n; ++i)
+            x.c[i] = zp_add(x.c[i], y.c[i], p);
+
+        return x;
+    }
+
+    // The sum cannot wrap, and s - p wraps exactly when s < p: branch-free, so it vectorizes
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_add(x.c[i], y.c[i], p);
+    {
+        uint64_t s = x.c[i].v + y.c[i].v;
+
+        x.c[i].v = min(s, s - p);
+    }
 
     return x;
 }
@@ -89,8 +263,21 @@ zp_vec_t zp_vec_neg(zp_vec_t x, uint64_t p)
 
 zp_vec_t zp_vec_self_sub(zp_vec_t x, zp_vec_t y, uint64_t p)
 {
+    if (p >> 63)
+    {
+        for (size_t i = 0; i < x.n; ++i)
+            x.c[i] = zp_sub(x.c[i], y.c[i], p);
+
+        return x;
+    }
+
+    // d + p wraps back below p exactly when d did
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_sub(x.c[i], y.c[i], p);
+    {
+        uint64_t d = x.c[i].v - y.c[i].v;
+
+        x.c[i].v = min(d, d + p);
+    }
 
     return x;
 }
@@ -101,22 +288,50 @@ zp_vec_t zp_vec_sub(zp_vec_t x, zp_vec_t y, uint64_t p)
 }
 
 zp_vec_t zp_vec_self_smul(zp_vec_t x, zp_t a, uint64_t p)
+{
+    // a may be unreduced, zp_prep_new needs it below p
+    return zp_vec_self_smul_prepared(x, zp_prep_new(zp_new(a.v % p), p), p);
+}
+
+zp_vec_t zp_vec_smul(zp_vec_t x, zp_t a, uint64_t p)
+{
+    return zp_vec_self_smul(zp_vec_new_copy(x), a, p);
+}
+
+zp_vec_t zp_vec_self_smul_prepared(zp_vec_t x, zp_prep_t a, uint64_t p)
 {
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_mul(x.c[i], a, p);
+        x.c[i] = zp_prep_mul(x.c[i], a, p);
 
     return x;
 }
 
-zp_vec_t zp_vec_smul(zp_vec_t x, zp_t a, uint64_t p)
+zp_vec_t zp_vec_smul_prepared(zp_vec_t x, zp_prep_t a, uint64_t p)
 {
-    return zp_vec_self_smul(zp_vec_new_copy(x), a, p);
+    return zp_vec_self_smul_prepared(zp_vec_new_copy(x), a, p);
 }
 
 zp_vec_t zp_vec_self_hmul(zp_vec_t x, zp_vec_t y, uint64_t p)
 {
-    for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_mul(x.c[i], y.c[i], p);
+    zp_ctx_t ctx = zp_ctx_new(p);
+    size_t i = 0;
+
+    // Two REDCs still beat a division: REDC(REDC(x * y) * 2^128) = x * y
+    if (p & 1)
+    {
+#ifdef ZP_VEC_SIMD_BITS
+        if (p >> ZP_VEC_SIMD_BITS == 0)
+            i = zp_vec_hmul_simd(x.c, y.c, x.n, &ctx);
+#endif
+
+        for (; i < x.n; ++i)
+            x.c[i] = zp_mont_mul(zp_mont_mul(x.c[i], y.c[i], &ctx), (zp_t){ctx.r2}, &ctx);
+
+        return x;
+    }
+
+    for (; i < x.n; ++i)
+        x.c[i] = zp_ctx_mul(x.c[i], y.c[i], &ctx);
 
     return x;
 }
@@ -128,8 +343,47 @@ zp_vec_t zp_vec_hmul(zp_vec_t x, zp_vec_t y, uint64_t p)
 
 zp_vec_t zp_vec_self_inv(zp_vec_t x, uint64_t p)
 {
+    zp_ctx_t ctx = zp_ctx_new(p);
+    zp_vec_t pre = zp_vec_new_empty(x.n);
+    bool mont = p & 1;
+    zp_t acc = mont ? zp_mont_one(&ctx) : zp_one();
+
+    // Montgomery's trick: prefix products, a single inversion, then the prefixes peel the
+    // elements off backwards. Zeros are skipped and stay zero, as with zp_inv.
     for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_inv(x.c[i], p);
+    {
+        if (mont)
+            x.c[i] = zp_to_mont(x.c[i], &ctx);
+
+        pre.c[i] = acc;
+        if (x.c[i].v)
+            acc = mont ? zp_mont_mul(acc, x.c[i], &ctx) : zp_ctx_mul(acc, x.c[i], &ctx);
+    }
+
+    acc = mont ? zp_to_mont(zp_inv(zp_from_mont(acc, &ctx), p), &ctx) : zp_inv(acc, p);
+
+    for (size_t i = x.n; i-- > 0;)
+    {
+        zp_t y = x.c[i];
+
+        // Some element shares a factor with p: only zp_inv can tell which
+        if (!acc.v)
+            y = zp_inv(mont ? zp_from_mont(y, &ctx) : y, p);
+        else if (y.v && mont)
+        {
+            y = zp_from_mont(zp_mont_mul(acc, pre.c[i], &ctx), &ctx);
+            acc = zp_mont_mul(acc, x.c[i], &ctx);
+        }
+        else if (y.v)
+        {
+            y = zp_ctx_mul(acc, pre.c[i], &ctx);
+            acc = zp_ctx_mul(acc, x.c[i], &ctx);
+        }
+
+        x.c[i] = y;
+    }
+
+    zp_vec_del(pre);
 
     return x;
 }
@@ -151,8 +405,10 @@ zp_vec_t zp_vec_sdiv(zp_vec_t x, zp_t a, uint64_t p)
 
 zp_vec_t zp_vec_self_hdiv(zp_vec_t x, zp_vec_t y, uint64_t p)
 {
-    for (size_t i = 0; i < x.n; ++i)
-        x.c[i] = zp_mul(x.c[i], zp_inv(y.c[i], p), p);
+    zp_vec_t z = zp_vec_inv(y, p);
+
+    zp_vec_self_hmul(x, z, p);
+    zp_vec_del(z);
 
     return x;
 }
@@ -164,12 +420,22 @@ zp_vec_t zp_vec_hdiv(zp_vec_t x, zp_vec_t y, uint64_t p)
 
 zp_t zp_vec_sum(zp_vec_t x, uint64_t p)
 {
-    zp_t z = zp_zero();
+    // 2^(64 - k) values of k bits add up without overflowing, so the blocks are plain word sums
+    size_t blk = (size_t)1 << __builtin_clzll(p);
+    uint128_t z = 0;
 
-    for (size_t i = 0; i < x.n; ++i)
-        z = zp_add(z, x.c[i], p);
+    for (size_t i = 0; i < x.n;)
+    {
+        size_t end = x.n - i > blk ? i + blk : x.n;
+        uint64_t s = 0;
 
-    return z;
+        for (; i < end; ++i)
+            s += x.c[i].v;
+
+        z += s;
+    }
+
+    return zp_new(zp_vec_reduce128(z, p));
 }
 
 zp_t zp_vec_prod(zp_vec_t x, uint64_t p)
@@ -184,25 +450,66 @@ zp_t zp_vec_prod(zp_vec_t x, uint64_t p)
 
 zp_t zp_vec_dot(zp_vec_t x, zp_vec_t y, uint64_t p)
 {
-    zp_vec_t z = zp_vec_hmul(x, y, p);
-    zp_t w = zp_vec_sum(z, p);
+#ifdef ZP_VEC_SIMD_BITS
+    if (p >> ZP_VEC_SIMD_BITS == 0)
+        return zp_vec_dot_simd(x.c, y.c, x.n, p);
+#endif
 
-    zp_vec_del(z);
+    zp_t z = zp_zero();
+    size_t k = 64 - __builtin_clzll(p);
+
+    // Products are below 2^(2k), so 2^(128 - 2k) of them add up in a double word and the blocks
+    // are reduced once. Only the largest moduli leave blocks too short to be worth it.
+    if (k <= 62)
+    {
+        size_t blk = k <= 32 ? SIZE_MAX : (size_t)1 << (128 - 2 * k);
+
+        for (size_t i = 0; i < x.n;)
+        {
+            size_t end = x.n - i > blk ? i + blk : x.n;
+            uint128_t s = 0;
 
-    return w;
+            for (; i < end; ++i)
+                s += (uint128_t)x.c[i].v * y.c[i].v;
+
+            z = zp_add(z, zp_new(zp_vec_reduce128(s, p)), p);
+        }
+
+        return z;
+    }
+
+    // Otherwise the overflows of the double word are counted in a third one
+    zp_ctx_t ctx = zp_ctx_new(p);
+    uint128_t s = 0;
+    uint64_t c = 0;
+
+    for (size_t i = 0; i < x.n; ++i)
+    {
+        uint128_t t = (uint128_t)x.c[i].v * y.c[i].v;
+
+        s += t;
+        c += s < t;
+    }
+
+    z = zp_ctx_mul(zp_new(c % p), zp_new(ctx.r2), &ctx);
+
+    return zp_ctx_add(z, zp_new(zp_vec_reduce128(s, p)), &ctx);
 }
 
 zp_vec_t zp_vec_self_circmul(zp_vec_t x, zp_vec_t m, uint64_t p)
 {
-    zp_vec_t y = zp_vec_new(x.n);
+    zp_vec_t y = zp_vec_new_empty(x.n);
 
+    // y_i = sum_j m_(j - i mod n) x_j, i.e. two dot products of contiguous slices
     for (size_t i = 0; i < y.n; ++i)
-        for (size_t j = 0; j < y.n; ++j)
-        {
-            size_t k = zp_as_int(zp_sub(zp_new(j), zp_new(i), y.n));
+    {
+        zp_vec_t x_lo = {.c = x.c, .n = i};
+        zp_vec_t x_hi = {.c = x.c + i, .n = y.n - i};
+        zp_t lo = zp_vec_dot(x_lo, (zp_vec_t){.c = m.c + x_hi.n, .n = x_lo.n}, p);
+        zp_t hi = zp_vec_dot(x_hi, (zp_vec_t){.c = m.c, .n = x_hi.n}, p);
 
-            y.c[i] = zp_add(y.c[i], zp_mul(m.c[k], x.c[j], p), p);
-        }
+        y.c[i] = zp_add(lo, hi, p);
+    }
 
     zp_vec_move(&x, y);
 